@@ -2,13 +2,161 @@
 #include "nlohmann/json.hpp"
 #include <iostream>
 #include <fstream>
+#include <sstream>
 
-int main() {
-    int c = suma(1, 2);
-    json values = experimentComplete(GraphType::TORUS_2D, 100, false);
-    std::ofstream file("results.json");
-    file << std::setw(4) << values << std::endl;
+// Command-line driver for the spanning-tree, BFS, connected-components and
+// UTS experiments.
+//
+// Every field of ws::Params can be given as a flag (--numThreads 1,2,4)
+// or in a JSON configuration file (--config exp.json). Comma separated
+// flags and JSON arrays are expanded into every combination. Flags
+// override the values of the configuration file.
+
+void usage()
+{
+    std::cout << "Usage: app [--config config.json] [--output results.ndjson] [--trace prefix]\n"
+              << "           [--graphType TORUS_2D,TORUS_3D] [--shape 100] [--directed false]\n"
+              << "           [--numThreads 1,2,4] [--algType CHASELEV,CILK,...]\n"
+              << "           [--numWarmUps 2] [--numIterExps 10] [--zeroCost true]\n"
+              << "           [--workload SPANNING_TREE,BFS_WS,BFS_TOP_DOWN,BFS_DIRECTION_OPT,\n"
+              << "                       CONNECTED_COMPONENTS,UTS]\n"
+              << "           [--utsTree GEOMETRIC --utsBranching 4 --utsDepth 10]\n"
+              << "           [--utsTree BINOMIAL --utsBranching 2000 --utsQ 0.124875 --utsM 8]\n"
+              << "           [--reorder NO_REORDER,BFS_ORDER,RCM,HILBERT]\n"
+              << "           [--<any ws::Params field> value[,value...]]\n"
+              << "Without arguments runs every algorithm on a 100x100 torus with 1..N threads."
+              << std::endl;
+}
+
+json parseValue(const std::string& item)
+{
+    if (item == "true") return true;
+    if (item == "false") return false;
+    try {
+        size_t pos;
+        int value = std::stoi(item, &pos);
+        if (pos == item.size()) return value;
+    } catch (const std::exception&) {}
+    return item;
+}
+
+json parseFlag(const std::string& value)
+{
+    json values = json::array();
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) values.emplace_back(parseValue(item));
+    }
+    if (values.size() == 1) return values[0];
+    return values;
+}
+
+int main(int argc, char** argv) {
+    json config;
+    json flags = json::object();
+    std::string output = "results.ndjson";
+    std::string tracePrefix;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                usage();
+                return 0;
+            }
+            if (arg.rfind("--", 0) != 0 || i + 1 >= argc) {
+                throw std::invalid_argument("Bad argument: " + arg);
+            }
+            std::string value = argv[++i];
+            if (arg == "--config") {
+                std::ifstream file(value);
+                if (!file) throw std::invalid_argument("Cannot open " + value);
+                file >> config;
+            } else if (arg == "--output") {
+                output = value;
+            } else if (arg == "--trace") {
+                tracePrefix = value;
+            } else {
+                flags[arg.substr(2)] = parseFlag(value);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        usage();
+        return 1;
+    }
+    if (!config.is_object()) {
+        const int numProcessors = std::thread::hardware_concurrency();
+        json threads = json::array();
+        json algorithms = json::array();
+        for (int i = 1; i <= numProcessors; i++) threads.emplace_back(i);
+        for (int at = AlgorithmType::CHASELEV; at != AlgorithmType::LAST; at++) {
+            algorithms.emplace_back(at);
+        }
+        config = {{"numThreads", threads}, {"algType", algorithms}};
+    }
+    config.update(flags);
+
+    std::vector<ws::Params> experiments;
+    try {
+        experiments = ws::expandParams(config);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    // One JSON object per line (NDJSON), flushed as soon as each
+    // configuration finishes so long sweeps can be followed with tail -f.
+    std::ofstream file(output);
+    if (!file) {
+        std::cerr << "Cannot open " << output << std::endl;
+        return 1;
+    }
+    json env = environmentFingerprint();
+    graph g;
+    json currentGraph;
+    json currentBaseline;
+    json baseline;
+    for (auto& p : experiments) {
+        json graphKey = {p.graphType, p.shape, p.directed, p.reorder};
+        // UTS generates its tree on the fly
+        if (p.workload == WorkloadType::UTS) {
+            graphKey = {p.utsTree, p.utsBranching, p.utsDepth, p.utsQ, p.utsM, p.utsSeed};
+        } else if (graphKey != currentGraph) {
+            g = graphFactory(p.graphType, p.shape, p.directed);
+            if (p.reorder != ReorderType::NO_REORDER) {
+                // Ids change, the results are comparable since the root is the same vertex
+                g = relabel(g, vertexOrder(g, p.reorder, std::thread::hardware_concurrency()));
+            }
+            currentGraph = graphKey;
+        }
+        json baselineKey = {graphKey, p.workload};
+        if (baselineKey != currentBaseline) {
+            currentBaseline = baselineKey;
+            // Sequential baseline used for speedup and work inflation
+            baseline = baselineStatistics(p, g);
+            baseline["environment"] = env;
+            file << baseline.dump() << std::endl;
+        }
+        if (p.algType == AlgorithmType::SIMPLE) continue;
+        json result = experimentStatistics(p, g);
+        addBaselineMetrics(result, baseline);
+        if (!tracePrefix.empty()) {
+            // Extra traced run, so the measured ones are not perturbed
+            tracer t(p.numThreads, 1 << 16);
+            json traced = experiment(p, g, &t);
+            std::string path = string_format("%s_%s_%s_%d.json", tracePrefix.c_str(),
+                                             getGraphTypeFromEnum(p.graphType).c_str(),
+                                             getAlgorithmTypeFromEnum(p.algType).c_str(),
+                                             p.numThreads);
+            std::ofstream traceFile(path);
+            traceFile << t.toChromeTrace() << std::endl;
+            result["trace"] = traced["trace"];
+            result["traceFile"] = path;
+        }
+        result["environment"] = env;
+        file << result.dump() << std::endl;
+    }
     file.close();
-    std::cout << c << std::endl;
     return 0;
 }
@@ -0,0 +1,362 @@
+#include "ws/lib.hpp"
+#include "nlohmann/json.hpp"
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <random>
+#include <sstream>
+
+////////////////////////////////////////////////////////////////////
+// Microbenchmarks of the work-stealing algorithms, without graphs //
+////////////////////////////////////////////////////////////////////
+
+// Each scenario builds one deque per thread with
+// workStealingAlgorithmFactory and drives it directly, so the numbers
+// only contain the cost of put/take/steal (plus the clock reads used to
+// sample the latency of every operation).
+
+using benchClock = std::chrono::steady_clock;
+
+enum BenchScenario {
+    OWNER_ONLY,    // Every thread puts and takes on its own deque
+    OWNER_THIEVES, // Thread 0 puts and takes, the others only steal from it
+    ALL_TO_ALL,    // Every thread puts, takes and steals from random victims
+    EXPAND,        // Thread 0 puts into a tiny deque while the others steal
+    LAST_SCENARIO
+};
+
+struct BenchOptions {
+    int ops = 1 << 18;    // Operations per thread
+    int batch = 64;       // Tasks put between takes
+    int structSize = 8192;
+    int expandSize = 2;   // Initial capacity used by the EXPAND scenario
+    std::vector<int> threads;
+    std::vector<AlgorithmType> algorithms;
+    std::vector<BenchScenario> scenarios;
+    std::string output;
+};
+
+std::string getScenarioFromEnum(BenchScenario scenario)
+{
+    switch (scenario) {
+    case BenchScenario::OWNER_ONLY:
+        return "OWNER_ONLY";
+    case BenchScenario::OWNER_THIEVES:
+        return "OWNER_THIEVES";
+    case BenchScenario::ALL_TO_ALL:
+        return "ALL_TO_ALL";
+    case BenchScenario::EXPAND:
+        return "EXPAND";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+BenchScenario getScenarioFromString(std::string scenario)
+{
+    for (int s = BenchScenario::OWNER_ONLY; s != BenchScenario::LAST_SCENARIO; s++) {
+        BenchScenario bs = static_cast<BenchScenario>(s);
+        if (scenario == getScenarioFromEnum(bs)) return bs;
+    }
+    throw std::invalid_argument("Unknown scenario: " + scenario);
+}
+
+// Latency samples (in nanoseconds) of one kind of operation.
+struct latencies {
+    std::vector<long long> samples;
+    long long hits = 0; // Operations that returned a task
+    long long aborts = 0; // Steals that found the victim locked and gave up
+
+    explicit latencies(int expected) { samples.reserve(expected); }
+
+    template<typename Op>
+    int measure(Op op) {
+        auto start = benchClock::now();
+        int result = op();
+        auto end = benchClock::now();
+        samples.emplace_back(std::chrono::duration<long long, std::nano>(end - start).count());
+        if (result >= 0) hits++;
+        if (result == ABORT) aborts++;
+        return result;
+    }
+};
+
+json percentiles(std::vector<latencies>& perThread)
+{
+    std::vector<long long> all;
+    long long hits = 0, aborts = 0;
+    for (auto& l : perThread) {
+        all.insert(all.end(), l.samples.begin(), l.samples.end());
+        hits += l.hits;
+        aborts += l.aborts;
+    }
+    json result;
+    result["count"] = all.size();
+    result["hits"] = hits;
+    result["aborts"] = aborts;
+    if (all.empty()) return result;
+    std::sort(all.begin(), all.end());
+    auto at = [&all](double p) { return all[static_cast<size_t>(p * (all.size() - 1))]; };
+    result["p50"] = at(0.50);
+    result["p90"] = at(0.90);
+    result["p99"] = at(0.99);
+    result["p999"] = at(0.999);
+    result["max"] = all.back();
+    return result;
+}
+
+// Runs func(processID) on numThreads pinned threads and returns the
+// wall time elapsed since all of them passed the starting barrier.
+long long runThreads(int numThreads, const std::function<void(int)>& func)
+{
+    benchClock::time_point start;
+    auto on_begin = [&start]() noexcept { start = benchClock::now(); };
+    std::barrier sync_point(numThreads, on_begin);
+    std::vector<std::thread> threads;
+    const int numProcessors = std::thread::hardware_concurrency();
+    for (int i = 0; i < numThreads; i++) {
+        threads.emplace_back([&, i]() {
+            sync_point.arrive_and_wait();
+            func(i);
+        });
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(i % numProcessors, &cpuset);
+        int rc = pthread_setaffinity_np(threads[i].native_handle(),
+                                        sizeof(cpu_set_t), &cpuset);
+        if (rc != 0) {
+            std::cerr << "Error calling pthread_setaffinity_np: " << rc << "\n";
+        }
+    }
+    for (std::thread &th : threads) {
+        if (th.joinable()) th.join();
+    }
+    auto end = benchClock::now();
+    return std::chrono::duration<long long, std::nano>(end - start).count();
+}
+
+json runScenario(BenchScenario scenario, AlgorithmType algType, int numThreads,
+                 const BenchOptions& opts)
+{
+    bool special = isSpecial(algType);
+    int capacity = scenario == BenchScenario::EXPAND ? opts.expandSize : opts.structSize;
+    std::vector<workStealingAlgorithm*> algs(numThreads);
+    for (int i = 0; i < numThreads; i++) {
+        algs[i] = workStealingAlgorithmFactory(algType, capacity, numThreads);
+    }
+    std::vector<latencies> puts(numThreads, latencies(0));
+    std::vector<latencies> takes(numThreads, latencies(0));
+    std::vector<latencies> steals(numThreads, latencies(0));
+    std::atomic<bool> done = false;
+    const int ops = opts.ops;
+    const int batch = opts.batch;
+
+    auto ownerOnly = [&](int id) {
+        dequeHandle own(algs[id], special, id);
+        puts[id] = latencies(ops / 2);
+        takes[id] = latencies(ops / 2);
+        for (int n = 0; n < ops; n += 2 * batch) {
+            for (int i = 0; i < batch; i++) puts[id].measure([&] { own.put(n + i); return 0; });
+            for (int i = 0; i < batch; i++) takes[id].measure([&] { return own.take(); });
+        }
+    };
+
+    auto ownerThieves = [&](int id) {
+        if (id == 0) {
+            dequeHandle own(algs[0], special, 0);
+            puts[0] = latencies(ops);
+            takes[0] = latencies(ops / 2);
+            for (int i = 0; i < ops; i++) {
+                puts[0].measure([&] { own.put(i); return 0; });
+                if (i % 2 == 1) takes[0].measure([&] { return own.take(); });
+            }
+            done = true;
+        } else {
+            dequeHandle victim(algs[0], special, id);
+            steals[id] = latencies(ops);
+            while (!done.load(relaxed)) {
+                steals[id].measure([&] { return victim.steal(); });
+            }
+        }
+    };
+
+    auto allToAll = [&](int id) {
+        dequeHandle own(algs[id], special, id);
+        std::mt19937 gen(id + 1);
+        std::uniform_int_distribution<> distrib(0, numThreads - 1);
+        puts[id] = latencies(ops / 2);
+        takes[id] = latencies(ops / 4);
+        steals[id] = latencies(ops / 4);
+        for (int n = 0; n < ops; n += 2 * batch) {
+            for (int i = 0; i < batch; i++) puts[id].measure([&] { own.put(n + i); return 0; });
+            for (int i = 0; i < batch / 2; i++) takes[id].measure([&] { return own.take(); });
+            if (numThreads == 1) continue;
+            for (int i = 0; i < batch / 2; i++) {
+                int victim = distrib(gen);
+                if (victim == id) victim = mod(victim + 1, numThreads);
+                dequeHandle other(algs[victim], special, id);
+                steals[id].measure([&] { return other.steal(); });
+            }
+        }
+    };
+
+    auto expand = [&](int id) {
+        if (id == 0) {
+            dequeHandle own(algs[0], special, 0);
+            puts[0] = latencies(ops);
+            for (int i = 0; i < ops; i++) puts[0].measure([&] { own.put(i); return 0; });
+            done = true;
+        } else {
+            dequeHandle victim(algs[0], special, id);
+            steals[id] = latencies(ops);
+            while (!done.load(relaxed)) {
+                steals[id].measure([&] { return victim.steal(); });
+            }
+        }
+    };
+
+    long long duration = 0;
+    switch (scenario) {
+    case BenchScenario::OWNER_ONLY:
+        duration = runThreads(numThreads, ownerOnly);
+        break;
+    case BenchScenario::OWNER_THIEVES:
+        duration = runThreads(numThreads, ownerThieves);
+        break;
+    case BenchScenario::ALL_TO_ALL:
+        duration = runThreads(numThreads, allToAll);
+        break;
+    case BenchScenario::EXPAND:
+        duration = runThreads(numThreads, expand);
+        break;
+    default:
+        break;
+    }
+    for (auto alg : algs) delete alg;
+
+    json result;
+    result["scenario"] = getScenarioFromEnum(scenario);
+    result["algorithm"] = getAlgorithmTypeFromEnum(algType);
+    result["numThreads"] = numThreads;
+    result["executionTime"] = duration;
+    if (algType == AlgorithmType::CHASELEV_MEMBARRIER || algType == AlgorithmType::CILK_MEMBARRIER) {
+        // Otherwise these ran with a fence on both sides
+        result["membarrier"] = membarrierAvailable();
+    }
+    json latency;
+    latency["put"] = percentiles(puts);
+    latency["take"] = percentiles(takes);
+    latency["steal"] = percentiles(steals);
+    long long totalOps = latency["put"]["count"].get<long long>()
+        + latency["take"]["count"].get<long long>()
+        + latency["steal"]["count"].get<long long>();
+    result["ops"] = totalOps;
+    result["opsPerSec"] = duration > 0 ? (totalOps * 1e9) / duration : 0.0;
+    // Tasks actually moved to thieves; convoys on a victim lower it
+    long long stolen = latency["steal"]["hits"].get<long long>();
+    result["stealsPerSec"] = duration > 0 ? (stolen * 1e9) / duration : 0.0;
+    result["latency"] = latency;
+    return result;
+}
+
+template<typename T>
+std::vector<T> parseList(const std::string& value, const std::function<T(const std::string&)>& parse)
+{
+    std::vector<T> values;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) values.emplace_back(parse(item));
+    }
+    return values;
+}
+
+void usage()
+{
+    std::cout << "Usage: ws_bench [--ops N] [--batch N] [--struct-size N] [--expand-size N]\n"
+              << "                [--threads 1,2,4] [--algorithms CHASELEV,CILK,...]\n"
+              << "                [--scenarios OWNER_ONLY,OWNER_THIEVES,ALL_TO_ALL,EXPAND]\n"
+              << "                [--output bench.json]" << std::endl;
+}
+
+BenchOptions parseOptions(int argc, char** argv)
+{
+    BenchOptions opts;
+    auto toInt = [](const std::string& s) { return std::stoi(s); };
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            usage();
+            std::exit(0);
+        }
+        if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+        std::string value = argv[++i];
+        if (arg == "--ops") opts.ops = std::stoi(value);
+        else if (arg == "--batch") opts.batch = std::stoi(value);
+        else if (arg == "--struct-size") opts.structSize = std::stoi(value);
+        else if (arg == "--expand-size") opts.expandSize = std::stoi(value);
+        else if (arg == "--threads") opts.threads = parseList<int>(value, toInt);
+        else if (arg == "--algorithms") opts.algorithms = parseList<AlgorithmType>(value, getAlgorithmTypeFromString);
+        else if (arg == "--scenarios") opts.scenarios = parseList<BenchScenario>(value, getScenarioFromString);
+        else if (arg == "--output") opts.output = value;
+        else throw std::invalid_argument("Unknown option: " + arg);
+    }
+    if (opts.batch < 2) opts.batch = 2;
+    if (opts.threads.empty()) {
+        const int numProcessors = std::thread::hardware_concurrency();
+        for (int n = 1; n < numProcessors; n *= 2) opts.threads.emplace_back(n);
+        opts.threads.emplace_back(numProcessors);
+    }
+    if (opts.algorithms.empty()) {
+        for (int at = AlgorithmType::CHASELEV; at != AlgorithmType::LAST; at++) {
+            opts.algorithms.emplace_back(static_cast<AlgorithmType>(at));
+        }
+    }
+    if (opts.scenarios.empty()) {
+        for (int s = BenchScenario::OWNER_ONLY; s != BenchScenario::LAST_SCENARIO; s++) {
+            opts.scenarios.emplace_back(static_cast<BenchScenario>(s));
+        }
+    }
+    return opts;
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions opts;
+    try {
+        opts = parseOptions(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        usage();
+        return 1;
+    }
+    json results = json::array();
+    std::cout << string_format("%-14s %-20s %7s %12s %9s %9s %9s",
+                               "scenario", "algorithm", "threads", "Mops/s",
+                               "p50(ns)", "p99(ns)", "max(ns)") << std::endl;
+    for (auto scenario : opts.scenarios) {
+        for (auto algType : opts.algorithms) {
+            for (auto numThreads : opts.threads) {
+                json r = runScenario(scenario, algType, numThreads, opts);
+                // Report the latency of the operation that dominates the scenario.
+                json& l = r["latency"][scenario == BenchScenario::OWNER_ONLY ? "take" :
+                                       scenario == BenchScenario::ALL_TO_ALL ? "take" : "put"];
+                std::cout << string_format("%-14s %-20s %7d %12.3f %9lld %9lld %9lld",
+                                           r["scenario"].get<std::string>().c_str(),
+                                           r["algorithm"].get<std::string>().c_str(),
+                                           numThreads,
+                                           r["opsPerSec"].get<double>() / 1e6,
+                                           l.value("p50", 0LL), l.value("p99", 0LL),
+                                           l.value("max", 0LL)) << std::endl;
+                results.emplace_back(r);
+            }
+        }
+    }
+    if (!opts.output.empty()) {
+        std::ofstream file(opts.output);
+        file << std::setw(4) << results << std::endl;
+        file.close();
+    }
+    return 0;
+}
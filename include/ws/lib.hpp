@@ -7,6 +7,7 @@
 #include <atomic>
 #include <mutex>
 #include <climits>
+#include <cstdint>
 #include <chrono>
 #include <thread>
 #include <barrier>
@@ -15,6 +16,8 @@
 #include <memory>
 #include <string>
 #include <stdexcept>
+#include <functional>
+#include <random>
 #include "nlohmann/json.hpp"
 
 using json = nlohmann::json;
@@ -43,6 +46,7 @@ std::string string_format( const std::string& format, Args ... args )
 static const int EMPTY = -1;
 static const int BOTTOM = -2;
 static const int TOP = -3;
+static const int ABORT = -4; // steal gave up on a contended victim; another may have tasks
 
 static constexpr std::memory_order relaxed = std::memory_order_relaxed;
 static constexpr std::memory_order consume = std::memory_order_consume;
@@ -66,7 +70,6 @@ enum GraphType {
 };
 
 enum AlgorithmType {
-    // SIMPLE,  // No work-stealing algorithm
     CHASELEV, // Chase-Lev work-stealing algorithm
     CILK,  // Cilk THE work-stealing algorithm
     IDEMPOTENT_FIFO,  // Idempotent work-stealing first-in first-out
@@ -76,8 +79,43 @@ enum AlgorithmType {
     WS_NC_MULT_OPT,   // Work-stealing with multiplicity optimized ("infinite array")
     WS_NC_MULT_LA_OPT,// Work-stealing with multiplicity optimized ("linked-lists")
     B_WS_NC_MULT_OPT, // Work-stealing bounded with multiplicity ("infinite array")
-    // B_WS_NC_MULT_LA_OPT // Work-stealing bounded with multiplicity ("linked-lists")
-    LAST
+    B_WS_NC_MULT_LA_OPT, // Work-stealing bounded with multiplicity ("linked-lists")
+    WS_NC_MULT_RING_OPT, // Work-stealing with multiplicity over a growable ring
+    CILK_TTAS,   // Cilk THE with a test-and-test-and-set spinlock
+    CILK_TICKET, // Cilk THE with a ticket lock
+    CILK_MCS,    // Cilk THE with an MCS queue lock
+    CHASELEV_FENCE_FREE, // Chase-Lev without the fence in take (bounded TSO, delta gap)
+    CILK_FENCE_FREE,     // Cilk THE without the fence in take (bounded TSO, delta gap)
+    CHASELEV_MEMBARRIER, // Chase-Lev, thieves fence for the owner with membarrier
+    CILK_MEMBARRIER,     // Cilk THE, thieves fence for the owner with membarrier
+    LAST,
+    // After LAST so the loops over the deques skip it and the numbers of the
+    // algorithms stay those of older params files
+    SIMPLE  // No work-stealing algorithm (sequential baseline)
+};
+
+enum WorkloadType {
+    SPANNING_TREE,     // Unordered traversal building a spanning tree
+    BFS_WS,            // Asynchronous BFS, vertices relaxed straight from the deques
+    BFS_TOP_DOWN,      // Level-synchronous top-down BFS, levels balanced on the deques
+    BFS_DIRECTION_OPT, // Level-synchronous, switching between top-down and bottom-up
+    CONNECTED_COMPONENTS, // Label propagation on the deques plus a union-find pass
+    UTS                  // Unbalanced Tree Search on the fork-join scheduler, no graph
+};
+
+// Shapes of the UTS trees (Olivier et al., "UTS: An Unbalanced Tree Search
+// Benchmark").
+enum UtsTreeType {
+    BINOMIAL,  // The root has utsBranching children, the rest utsM with probability utsQ
+    GEOMETRIC  // Geometric number of children of mean utsBranching, up to utsDepth
+};
+
+// Relabelings of the vertices that put neighbours close in memory.
+enum ReorderType {
+    NO_REORDER, // Ids as generated (row-major on the tori)
+    BFS_ORDER,  // Order of discovery of a BFS from the root
+    RCM,        // Reverse Cuthill-McKee, small bandwidth
+    HILBERT     // Position along a Hilbert curve, tori only
 };
 
 enum StepSpanningTreeType {
@@ -91,6 +129,25 @@ enum GraphCycleType {
     TREE
 };
 
+enum TraceEventType {
+    TRACE_PUT,
+    TRACE_TAKE,
+    TRACE_STEAL_ATTEMPT,
+    TRACE_STEAL_SUCCESS,
+    TRACE_IDLE_BEGIN,
+    TRACE_IDLE_END
+};
+
+enum PerfEvent {
+    CYCLES,
+    INSTRUCTIONS,
+    L1D_MISSES,
+    LLC_MISSES,
+    BRANCH_MISSES,
+    CONTEXT_SWITCHES,
+    NUM_PERF_EVENTS
+};
+
 ////////////////////////////
 // Graphs and graph utils //
 ////////////////////////////
@@ -252,14 +309,76 @@ public:
     }
 };
 
-class chaselev : public workStealingAlgorithm {
+// How take orders the owner's store of T before its load of H, the
+// StoreLoad that otherwise needs a fence on every take.
+enum OwnerFence {
+    FULL_FENCE, // seq_cst fence on every take
+    // No fence. On TSO a store stays invisible only while it is in the
+    // store buffer, so thieves see a T at most delta (the entries of the
+    // buffer) above the real one; they leave the last delta tasks to the
+    // owner and the owner cannot meet them (Morrison and Afek). Only x86
+    // is TSO with a bounded buffer; elsewhere take keeps its fence.
+    DELTA_GAP,
+    // Asymmetric Dekker: the owner only keeps the compiler from reordering
+    // and thieves, which are rare, run membarrier, a fence on every thread
+    // of the process. Without membarrier both sides use fences.
+    MEMBARRIER
+};
+
+// Registers the process for MEMBARRIER_CMD_PRIVATE_EXPEDITED on the first
+// call; whether it can be used (Linux 4.14 and later).
+bool membarrierAvailable();
+
+// A fence on every running thread of the process, or on the caller only
+// when membarrier is not available. Aborts if membarrier fails after a
+// successful registration.
+void processWideFence();
+
+// The StoreLoad of take: a compiler barrier with DELTA_GAP on x86 and with
+// MEMBARRIER when available, a full fence otherwise.
+template <OwnerFence F>
+inline void ownerFence()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if constexpr (F == DELTA_GAP) {
+        std::atomic_signal_fence(seq_cst);
+        return;
+    }
+#endif
+    if constexpr (F == MEMBARRIER) {
+        if (membarrierAvailable()) {
+            std::atomic_signal_fence(seq_cst);
+            return;
+        }
+    }
+    std::atomic_thread_fence(seq_cst);
+}
+
+// The fence of a thief between its write or read of H and its read of T.
+template <OwnerFence F>
+inline void thiefFence()
+{
+    if constexpr (F == MEMBARRIER) {
+        processWideFence();
+    } else {
+        std::atomic_thread_fence(seq_cst);
+    }
+}
+
+// Larger than the store buffer of current x86 cores (56 to 114 entries),
+// each of which holds at most one pending take.
+static const int STORE_BUFFER_DELTA = 128;
+
+template <OwnerFence F>
+class basicChaseLev : public workStealingAlgorithm {
 private:
     std::atomic<int> H;
     std::atomic<int> T;
     int tasksSize;
     std::unique_ptr<std::atomic<int>[]> tasks;
+    int delta; // Tasks thieves leave to the owner, only with DELTA_GAP
 public:
-    explicit chaselev(int initialSize);
+    explicit basicChaseLev(int initialSize, int delta = STORE_BUFFER_DELTA);
 
     bool isEmpty() override;
 
@@ -278,15 +397,104 @@ public:
 
 };
 
-class cilk : public workStealingAlgorithm {
+// Instantiated in chaselev.cpp.
+using chaselev = basicChaseLev<FULL_FENCE>;
+using chaselevFenceFree = basicChaseLev<DELTA_GAP>;
+using chaselevMembarrier = basicChaseLev<MEMBARRIER>;
+
+///////////
+// Locks //
+///////////
+
+// Locks for the THE protocol of cilk, all with lock, try_lock and unlock
+// so they fit std::lock_guard and std::unique_lock like std::mutex.
+
+// Spin-wait hint: pause on x86, yield elsewhere.
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// Test-and-test-and-set: waiters spin on their cached copy and only
+// write when the lock looks free.
+class ttasLock {
+private:
+    std::atomic<bool> locked_ = false;
+public:
+    void lock()
+    {
+        while (locked_.exchange(true, acquire)) {
+            while (locked_.load(relaxed)) cpuRelax();
+        }
+    }
+
+    bool try_lock() { return !locked_.load(relaxed) && !locked_.exchange(true, acquire); }
+
+    void unlock() { locked_.store(false, release); }
+};
+
+// FIFO: every waiter takes a ticket and waits for its turn.
+class ticketLock {
+private:
+    std::atomic<unsigned> next_ = 0;
+    std::atomic<unsigned> serving_ = 0;
+public:
+    void lock()
+    {
+        unsigned ticket = next_.fetch_add(1, relaxed);
+        while (serving_.load(acquire) != ticket) cpuRelax();
+    }
+
+    // Only when nobody holds or waits for the lock.
+    bool try_lock()
+    {
+        unsigned ticket = serving_.load(acquire);
+        return next_.compare_exchange_strong(ticket, ticket + 1, acquire, relaxed);
+    }
+
+    void unlock() { serving_.store(serving_.load(relaxed) + 1, release); }
+};
+
+// FIFO queue of waiters, each spinning on its own node, so a release
+// invalidates one cache line instead of every waiter's. Nodes are per
+// thread, so a thread must not hold or wait for two MCS locks at once (a
+// worker only locks one deque at a time).
+class mcsLock {
+private:
+    struct alignas(64) node {
+        std::atomic<node*> next = nullptr;
+        std::atomic<bool> locked = false;
+    };
+    std::atomic<node*> tail_ = nullptr;
+
+    static node& own()
+    {
+        static thread_local node n;
+        return n;
+    }
+public:
+    void lock();
+
+    bool try_lock();
+
+    void unlock();
+};
+
+template <typename Lock, OwnerFence F = FULL_FENCE>
+class basicCilk : public workStealingAlgorithm {
 private:
     std::atomic<int> H;
     std::atomic<int> T;
     int tasksSize;
     std::unique_ptr<std::atomic<int>[]> tasks;
-    std::mutex mtx;
+    Lock mtx;
+    int delta; // Tasks thieves leave to the owner, only with DELTA_GAP
 public:
-    explicit cilk(int initialSize);
+    explicit basicCilk(int initialSize, int delta = STORE_BUFFER_DELTA);
 
     bool isEmpty() override;
 
@@ -304,6 +512,14 @@ public:
     }
 };
 
+// Instantiated in cilk.cpp.
+using cilk = basicCilk<std::mutex>;
+using cilkTTAS = basicCilk<ttasLock>;
+using cilkTicket = basicCilk<ticketLock>;
+using cilkMCS = basicCilk<mcsLock>;
+using cilkFenceFree = basicCilk<std::mutex, DELTA_GAP>;
+using cilkMembarrier = basicCilk<std::mutex, MEMBARRIER>;
+
 class idempotentFIFO : public workStealingAlgorithm {
 private:
     std::atomic<int> head;
@@ -455,6 +671,54 @@ public:
     }
 };
 
+// Storage of wsncmultring: position p lives at tasks[p % capacity].
+struct TaskRing {
+    int capacity;
+    std::atomic<int>* tasks;
+};
+
+// Work-stealing with multiplicity reusing the slots every label has
+// already passed. It only grows when the live tasks (from the smallest
+// head to tail) do not fit, so memory follows the frontier instead of the
+// number of puts.
+class wsncmultring : public workStealingAlgorithm {
+private:
+    int processors;
+    std::atomic<int> tail;
+    std::atomic<int> Head; // Monotonic, slots behind it may be reused
+    int* head;
+    // Position a thief may be reading, INT_MAX while it is not stealing
+    std::atomic<int>* announced;
+    int reusable = 0; // Positions below this one are free (owner only)
+    std::atomic<TaskRing*> ring;
+    // Rings replaced by expand; a thief may still be reading them
+    std::vector<TaskRing*> retired;
+
+    int lowestHead();
+
+    void advanceHead(int position);
+public:
+    wsncmultring(int capacity, int numThreads);
+
+    ~wsncmultring() override;
+
+    bool put(int task, int label) override;
+
+    int take(int label) override;
+
+    int steal(int label) override;
+
+    bool isEmpty(int label) override;
+
+    void expand();
+
+    int getCapacity() const;
+
+    void printType() override {
+        std::cout << "WSNC_MULT_RING" << std::endl;
+    }
+};
+
 // To implement list-of-arrays for work-stealing with multiplicity,
 //     we need to declare an struct of nodes, where each node
 
@@ -561,17 +825,34 @@ public:
     NodeWS* getNext();
 };
 
+// Circular directory of wsncmultla segments: segment n lives at n % length.
+struct NodeDirectory {
+    int length;
+    NodeWS** nodes;
+};
+
 class wsncmultla : public workStealingAlgorithm {
 private:
     int arrayCapacity;
     int processors;
-    int tasksLength;
-    int tail;
-    std::atomic<int> Head;
-    int currentNodes = 0;
+    std::atomic<int> tail;
+    std::atomic<int> Head; // Monotonic, see advanceHead
+    int firstNode = 0;     // Oldest segment still reachable
+    int lastNode = 0;
     int length;
     int* head;
-    NodeWS** tasks;
+    // Position a thief may be reading, INT_MAX while it is not stealing
+    std::atomic<int>* announced;
+    std::atomic<NodeDirectory*> directory;
+    // Directories replaced by expand; a thief may still be reading them
+    std::vector<NodeDirectory*> retired;
+    std::vector<NodeWS*> freeNodes;
+
+    NodeWS& segment(int position);
+
+    void advanceHead(int position);
+
+    void recycle();
 public:
     wsncmultla(int initialSize, int arrayCapacity, int numThreads);
 
@@ -630,36 +911,82 @@ public:
 };
 
 
+// Segment of bwsncmultla: tasks plus one flag per slot telling whether
+// the task can still be stolen. Slots start as BOTTOM and stealable.
+class BNodeWS {
+private:
+    int capacity;
+    std::atomic<int>* array;
+    std::atomic<bool>* B;
+public:
+    explicit BNodeWS(int capacity);
+
+    ~BNodeWS();
+
+    std::atomic<int>& operator[](int i);
+
+    std::atomic<bool>& flag(int i);
+};
+
+// Bounded work-stealing with multiplicity over a list of segments. Same
+// semantics as bwsncmult, but growing only allocates a new segment (and,
+// rarely, a bigger directory of segment pointers) instead of copying the
+// tasks and flags.
 class bwsncmultla : public workStealingAlgorithm {
 private:
-    int tail;
-    int size;
+    int arrayCapacity;
+    int processors;
+    int tasksLength;
+    std::atomic<int> tail; // Released after the task, so thieves never see a missing segment
     std::atomic<int> Head;
-    int *head;
-    std::vector<int> tasks;
-    // std::vector<bool> B;
-
+    int currentNodes = 0;
+    int length;
+    int* head;
+    std::atomic<BNodeWS**> tasks;
+    // Directories replaced by expand; a thief may still be reading them
+    std::vector<BNodeWS**> retired;
 public:
-    bwsncmultla(int size, int numThreads);
+    bwsncmultla(int initialSize, int arrayCapacity, int numThreads);
 
-    ~bwsncmultla() override {
-        delete[] head;
-    }
+    ~bwsncmultla() override;
 
-    bool put(int task, int label);
+    bool put(int task, int label) override;
 
-    int take(int label);
+    int take(int label) override;
 
-    int steal(int label);
+    int steal(int label) override;
 
-    bool isEmpty(int label);
+    bool isEmpty(int label) override;
 
     void expand();
-    void printType() {
+
+    int getCapacity() const;
+
+    void printType() override {
         std::cout << "BWSNC_MULT_LA" << std::endl;
     }
 };
 
+// Hides the difference between the plain algorithms and the ones with
+// multiplicity, which need the label of the calling thread.
+class dequeHandle {
+private:
+    workStealingAlgorithm* alg_;
+    bool special_;
+    int label_;
+public:
+    dequeHandle(workStealingAlgorithm* alg, bool special, int label)
+        : alg_(alg), special_(special), label_(label) {}
+
+    bool put(int task) { return special_ ? alg_->put(task, label_) : alg_->put(task); }
+
+    int take() { return special_ ? alg_->take(label_) : alg_->take(); }
+
+    int steal() { return special_ ? alg_->steal(label_) : alg_->steal(); }
+
+    bool isEmpty() { return special_ ? alg_->isEmpty(label_) : alg_->isEmpty(); }
+};
+
 /////////////////////////
 // Auxiliary functions //
 /////////////////////////
@@ -677,24 +1004,118 @@ namespace ws {
         bool stealTime;
         bool allTime;
         bool specialExecution;
+        int numWarmUps = 0; // Discarded runs before the numIterExps measured ones
+        bool zeroCost = false; // Workers never steal, only put and take
+        bool hwCounters = false; // Hardware counters around each worker's traversal
+        bool claimOnce = true; // Claim vertices with a CAS on the color instead of check-then-store
+        int counterBatch = 64; // Vertices counted locally before adding them to the shared counter
+        int prefetchDistance = 8; // Neighbours ahead whose colors are prefetched (0 disables)
+        bool contiguousAdjacency = false; // Traverse a CSR copy of the adjacency lists
+        int taskBatch = 4; // Tasks expanded together on the CSR copy
+        bool simdFilter = true; // On the CSR copy, skip colored neighbours with AVX2/AVX-512 gathers
+        ReorderType reorder = ReorderType::NO_REORDER; // Relabeling applied to the graph before the runs
+        WorkloadType workload = WorkloadType::SPANNING_TREE;
+        UtsTreeType utsTree = UtsTreeType::GEOMETRIC; // Defaults are the T1 tree of UTS
+        double utsBranching = 4;
+        int utsDepth = 10;
+        double utsQ = 0.124875;
+        int utsM = 8;
+        int utsSeed = 19;
     };
 
     void to_json(json& j, const Params& p);
     void from_json(const json& j, Params& p);
+
+    Params defaultParams();
+
+    // Expands a configuration whose fields may be lists of values
+    // (e.g. {"numThreads": [1, 2, 4], "algType": ["CHASELEV", "CILK"]})
+    // into every combination of parameters.
+    std::vector<Params> expandParams(const json& config);
 }
 
 
+/////////////
+// Tracing //
+/////////////
+
+// Compiled in with -DWS_TRACE=ON (the default). When compiled out the
+// macro disappears; when compiled in, a worker without buffer pays one
+// branch per event.
+#ifdef WS_TRACING
+#define WS_TRACE(buffer, type, value) do { if (buffer) (buffer)->record(type, value); } while (0)
+#else
+#define WS_TRACE(buffer, type, value) do {} while (0)
+#endif
+
+struct traceEvent {
+    long long timestamp; // ns since the tracer was created
+    int type;
+    int value;           // Task, or victim for a steal attempt
+};
+
+// Ring of the last `capacity` events of one worker. Only the owner
+// writes; the position is published with release so the buffer can be
+// read once the worker has finished (or concurrently, for the events
+// already published).
+class traceBuffer {
+private:
+    std::unique_ptr<traceEvent[]> events;
+    size_t mask;
+    std::chrono::steady_clock::time_point origin;
+    std::atomic<size_t> next = 0;
+public:
+    traceBuffer(size_t capacity, std::chrono::steady_clock::time_point origin);
+
+    void record(TraceEventType type, int value) {
+        size_t i = next.load(relaxed);
+        auto ts = std::chrono::duration<long long, std::nano>(std::chrono::steady_clock::now() - origin).count();
+        events[i & mask] = traceEvent{ts, type, value};
+        next.store(i + 1, release);
+    }
+
+    // Events still in the ring, oldest first
+    std::vector<traceEvent> snapshot() const;
+
+    size_t dropped() const;
+};
+
+class tracer {
+private:
+    std::chrono::steady_clock::time_point origin;
+    std::vector<std::unique_ptr<traceBuffer>> buffers;
+public:
+    // capacity is rounded up to a power of two
+    tracer(int numWorkers, size_t capacity);
+
+    traceBuffer* worker(int id);
+
+    // Chrome trace / Perfetto JSON: one track per worker, idle periods as
+    // durations and the operations as instant events.
+    json toChromeTrace() const;
+
+    // Events of each type and idle time per worker
+    json summary() const;
+};
+
+std::string getTraceEventName(TraceEventType type);
+
 struct Report {
     std::atomic<int> takes = 0;
     std::atomic<int> puts = 0;
     std::atomic<int> steals = 0;
+    std::atomic<int> expansions = 0; // Taken vertices whose neighbours were visited
+    std::atomic<int> duplicates = 0; // Taken vertices that had already been expanded
     std::atomic<long long> maxSteal = LLONG_MIN;
     std::atomic<long long> minSteal = LLONG_MAX;
     std::atomic<long long> avgSteal = 0;
     std::atomic<long long> avgIter = 0;
     long long executionTime; // Maybe it could be change by some type provided in chronno header
+    long long stateBytes = 0; // Per-vertex state (colors, parents, visited) of the traversal
     int numProcessors_;
     int* processors_;
+    std::vector<std::vector<long long>> counters_; // perfCounters of each worker, empty if not measured
+    tracer* tracer_ = nullptr; // Events of each worker, if tracing
     Report(int numProcessors, int* processors) : numProcessors_(numProcessors), processors_(processors) {}
     ~Report() {
         delete[] processors_;
@@ -702,9 +1123,202 @@ struct Report {
     void incTakes() { ++takes; }
     void incPuts() { ++puts; }
     void incSteals() { ++steals; }
+    void incExpansions() { ++expansions; }
+    void incDuplicates() { ++duplicates; }
+
+};
+
+///////////////////////////////////
+// Hardware performance counters //
+///////////////////////////////////
+
+// Counters of the calling thread opened with perf_event_open. Events
+// that cannot be opened (no permission, virtual machines, other OS) are
+// reported as -1, so the experiments run anyway. When there are more
+// events than hardware counters the kernel multiplexes them, so each one
+// also reads the time it was enabled and the time it was counting, and
+// get() extrapolates the count to the whole enabled time.
+class perfCounters {
+private:
+    int fds[PerfEvent::NUM_PERF_EVENTS];
+    long long values[PerfEvent::NUM_PERF_EVENTS];
+    long long enabled[PerfEvent::NUM_PERF_EVENTS]; // ns
+    long long running[PerfEvent::NUM_PERF_EVENTS]; // ns
+public:
+    perfCounters();
+
+    ~perfCounters();
+
+    perfCounters(const perfCounters&) = delete;
+    perfCounters& operator=(const perfCounters&) = delete;
+
+    bool isAvailable() const;
+
+    void start();
+
+    // Adds the events counted since start()
+    void stop();
+
+    // Count scaled by enabled / running time; -1 if unavailable or the
+    // event never got a counter.
+    long long get(PerfEvent event) const;
+
+    long long enabledTime(PerfEvent event) const { return enabled[event]; }
+
+    long long runningTime(PerfEvent event) const { return running[event]; }
+};
+
+std::string getPerfEventName(PerfEvent event);
+
+// counters has, for each worker, the NUM_PERF_EVENTS scaled counts followed
+// by their enabled and their running times. Totals and per-worker values,
+// with the scaling applied to each event (1 without multiplexing) under
+// "scaling"; unavailable events are null.
+json perfToJson(const std::vector<std::vector<long long>>& counters);
+
+// Asks for the line at addr ahead of its use; rw is 1 when it will be
+// written. Compiles to nothing without the GCC builtin.
+#if defined(__GNUC__)
+#define WS_PREFETCH(addr, rw) __builtin_prefetch((addr), (rw), 3)
+#else
+#define WS_PREFETCH(addr, rw) ((void) (addr))
+#endif
+
+// One bit per vertex. testAndSet tells which of the workers racing for a
+// vertex set it first.
+class atomicBitmap {
+private:
+    int words_;
+    std::unique_ptr<std::atomic<uint64_t>[]> bits_;
+public:
+    explicit atomicBitmap(int size)
+        : words_((size + 63) / 64), bits_(new std::atomic<uint64_t>[words_]) {}
+
+    int numWords() const { return words_; }
+
+    void clearWord(int word) { bits_[word].store(0, relaxed); }
+
+    bool test(int i) const { return (bits_[i >> 6].load(relaxed) >> (i & 63)) & 1; }
+
+    // Returns whether the bit was clear.
+    bool testAndSet(int i)
+    {
+        uint64_t mask = uint64_t(1) << (i & 63);
+        return (bits_[i >> 6].fetch_or(mask) & mask) == 0;
+    }
+
+    size_t bytes() const { return words_ * sizeof(uint64_t); }
+};
+
+// Label of the worker that reached each vertex (0 when none did). Labels
+// go from 1 to numThreads, so one byte per vertex is enough up to 255
+// workers and two bytes beyond.
+class colorArray {
+private:
+    bool wide_;
+    std::unique_ptr<std::atomic<uint8_t>[]> narrow_;
+    std::unique_ptr<std::atomic<uint16_t>[]> wideColors_;
+    int size_;
+public:
+    // A few more entries than vertices: the SIMD filters read a 32-bit
+    // word from the position of each color.
+    colorArray(int size, int numThreads) : wide_(numThreads > UINT8_MAX), size_(size)
+    {
+        if (wide_) {
+            wideColors_.reset(new std::atomic<uint16_t>[size + 2]);
+            for (int i = size; i < size + 2; i++) wideColors_[i].store(0, relaxed);
+        } else {
+            narrow_.reset(new std::atomic<uint8_t>[size + 4]);
+            for (int i = size; i < size + 4; i++) narrow_[i].store(0, relaxed);
+        }
+    }
+
+    bool wide() const { return wide_; }
+
+    // The colors as bytes, for the SIMD filters.
+    const uint8_t* raw() const
+    {
+        return wide_ ? reinterpret_cast<const uint8_t*>(wideColors_.get())
+                     : reinterpret_cast<const uint8_t*>(narrow_.get());
+    }
+
+    int load(int v, std::memory_order order = seq_cst) const
+    {
+        return wide_ ? wideColors_[v].load(order) : narrow_[v].load(order);
+    }
+
+    void store(int v, int color, std::memory_order order = seq_cst)
+    {
+        if (wide_) {
+            wideColors_[v].store(static_cast<uint16_t>(color), order);
+        } else {
+            narrow_[v].store(static_cast<uint8_t>(color), order);
+        }
+    }
+
+    // Sets the color of v if it had none. Returns whether it did.
+    bool claim(int v, int color)
+    {
+        if (wide_) {
+            uint16_t expected = 0;
+            return wideColors_[v].compare_exchange_strong(expected, static_cast<uint16_t>(color));
+        }
+        uint8_t expected = 0;
+        return narrow_[v].compare_exchange_strong(expected, static_cast<uint8_t>(color));
+    }
+
+    // The color of v is about to be claimed.
+    void prefetch(int v) const
+    {
+        if (wide_) {
+            WS_PREFETCH(&wideColors_[v], 1);
+        } else {
+            WS_PREFETCH(&narrow_[v], 1);
+        }
+    }
 
+    size_t bytes() const { return size_ * (wide_ ? sizeof(uint16_t) : sizeof(uint8_t)); }
 };
 
+// Copy of the neighbours of a graph in two arrays (CSR): the neighbours of
+// v are targets[offsets[v]..offsets[v + 1]), so walking them, or fetching
+// the ones of the next vertex, does not chase std::list nodes.
+class adjacencyArray {
+private:
+    std::vector<int> offsets_;
+    std::vector<int> targets_;
+public:
+    explicit adjacencyArray(graph& g);
+
+    const int* begin(int v) const { return targets_.data() + offsets_[v]; }
+
+    const int* end(int v) const { return targets_.data() + offsets_[v + 1]; }
+
+    int degree(int v) const { return offsets_[v + 1] - offsets_[v]; }
+
+    // The offsets of v, which locate its neighbours.
+    void prefetch(int v) const { WS_PREFETCH(&offsets_[v], 0); }
+
+    size_t bytes() const { return (offsets_.size() + targets_.size()) * sizeof(int); }
+};
+
+// Kernels that pick the neighbours without color. The vector ones gather
+// the colors of 8 (AVX2) or 16 (AVX-512) neighbours at once; the best one
+// the processor supports is found at run time with CPUID.
+enum SimdKernel {
+    SCALAR_KERNEL,
+    AVX2_KERNEL,
+    AVX512_KERNEL
+};
+
+bool simdKernelSupported(SimdKernel kernel);
+SimdKernel bestSimdKernel();
+std::string getSimdKernelName(SimdKernel kernel);
+
+// Writes to out the vertices of [first, first + n) whose color is 0 and
+// returns how many. Colors may be set right after, so claiming still decides.
+int unvisitedNeighbours(const colorArray& colors, const int* first, int n, int* out, SimdKernel kernel);
+
 class AbstractStepSpanningTree
 {
 public:
@@ -714,14 +1328,15 @@ public:
     bool stealTime_;
     graph& g_;
     Report& report_;
-    std::atomic<int>* colors_;
+    colorArray& colors_;
     std::atomic<int>* parents_;
     workStealingAlgorithm* algorithm_;
     workStealingAlgorithm** algorithms_;
+    traceBuffer* trace_ = nullptr;
 
 
     AbstractStepSpanningTree(int root, int label, bool stealTime,
-                             graph& g, std::atomic<int>* colors,
+                             graph& g, colorArray& colors,
                              std::atomic<int>* parents,
                              workStealingAlgorithm* algorithm,
                              workStealingAlgorithm** algorithms,
@@ -748,22 +1363,72 @@ class CounterStepSpanningTree : public AbstractStepSpanningTree
 private:
     bool specialExecution_;
     std::atomic<int>& counter_;
-    std::atomic<int>* visited_;
+    atomicBitmap& visited_;
+    atomicBitmap& expanded_;
+    std::atomic<int>& active_; // Workers that may still put: non-empty deque or stealing
+    bool zeroCost_;
+    bool claimOnce_;
+    int counterBatch_;
+    int localCount_ = 0; // Vertices claimed but not yet added to counter_
+
+    // Adds the local count to counter_.
+    void flushCount();
+
+    // Termination by count, including the vertices not flushed yet.
+    bool allVisited() const { return counter_.load() + localCount_ >= g_.getNumberVertices(); }
+
+    // Whether the worker got w, reached from v, and has to put it.
+    bool claim(int w, int v);
+
+    // Whether v is expanded for the first time; repeats count as duplicates.
+    bool firstExpansion(int v);
+
+    // Whether a taken v has to be expanded.
+    bool shouldExpand(int v);
+
+    void putVertex(int w);
+
+    // Colors of the first prefetchDistance_ vertices of [first, last).
+    void prefetchColors(const int* first, const int* last) const;
+
+    // Claims and puts the neighbours of the n vertices of batch.
+    void expand(const int* batch, int n);
+    void expandList(int v);
 
 public:
+    static constexpr int maxTaskBatch = 16;
+    static constexpr int filterChunk = 64; // Neighbours filtered per call
+
+    // Locality knobs, set before graph_traversal_step.
+    const adjacencyArray* adjacency_ = nullptr; // Neighbours from g_ when null
+    int prefetchDistance_ = 0; // Neighbours whose colors are requested ahead; 0 disables
+    int taskBatch_ = 1; // Tasks taken and expanded together, only with adjacency_
+    bool filterNeighbours_ = false; // Filter colored neighbours with simdKernel_, only with adjacency_
+    SimdKernel simdKernel_ = SimdKernel::SCALAR_KERNEL;
+    // The deque hands out each task once (handsOutOnce), so with claimOnce_
+    // a taken vertex cannot be a duplicate and expanded_ is not checked.
+    bool handsOutOnce_ = false;
+
     CounterStepSpanningTree(int root, int label, bool stealTime,
-                            graph& g, std::atomic<int>* colors,
+                            graph& g, colorArray& colors,
                             std::atomic<int>* parents,
                             workStealingAlgorithm* algorithm,
                             workStealingAlgorithm* algorithms[],
                             Report& report, int numThreads,
                             bool specialExecution,
                             std::atomic<int>& counter,
-                            std::atomic<int>* visited)
+                            atomicBitmap& visited,
+                            atomicBitmap& expanded,
+                            std::atomic<int>& active,
+                            bool zeroCost = false,
+                            bool claimOnce = true,
+                            int counterBatch = 1)
     : AbstractStepSpanningTree(root, label, stealTime, g, colors, parents,
                                algorithm, algorithms, report, numThreads),
       specialExecution_(specialExecution), counter_(counter),
-      visited_(visited)
+      visited_(visited), expanded_(expanded), active_(active),
+      zeroCost_(zeroCost), claimOnce_(claimOnce),
+      counterBatch_(std::max(1, counterBatch))
     {}
 
     void graph_traversal_step();
@@ -785,6 +1450,7 @@ graph directedTorus3D40(int shape);
 // graph random(int numberVertices, int vertexDegree);
 // graph directedRandom(int numberVertices, int vertexDegree);
 graph buildFromParents(std::atomic<int>* parents, int totalParents, int root, bool directed);
+graph buildFromParents(int* parents, int totalParents, int root, bool directed);
 
 bool isCyclic(graph& g, std::unique_ptr<bool[]>& visited);
 bool hasCycle(graph* g);
@@ -792,10 +1458,84 @@ bool isTree(graph& g);
 
 graph spanningTree(graph& g, int* roots, Report& report, ws::Params& params);
 
+// Same traversal as spanningTree, on one thread, with a plain vector as
+// stack and without atomics. Baseline for speedup and work inflation.
+graph sequentialSpanningTree(graph& g, int root, Report& report);
+
 GraphCycleType detectCycleType(graph& g);
 
+// Distances and parents of a breadth-first search from root; vertices not
+// reached keep distance -1 and parent BOTTOM.
+struct bfsResult {
+    std::vector<int> distances;
+    std::vector<int> parents;
+    long long edges = 0;    // Edges in the component of root (numerator of TEPS)
+    int levels = 0;
+    int bottomUpLevels = 0; // Levels expanded bottom-up (BFS_DIRECTION_OPT)
+    long parentsTime = 0;   // Untimed pass rebuilding the parents (BFS_WS), ns
+};
+
+// Runs the BFS of params.workload with params.numThreads workers on
+// params.algType deques. SIMPLE runs sequentialBfs.
+bfsResult bfs(graph& g, int root, Report& report, ws::Params& params);
+
+// Queue based BFS on one thread. Baseline of the BFS workloads.
+bfsResult sequentialBfs(graph& g, int root, Report& report);
+
+// Checks root, levels and parents of result against the edges of g, in the
+// spirit of the Graph500 validation.
+bool validateBfs(graph& g, int root, const bfsResult& result);
+
+// Component of every vertex, named by its smallest vertex. Directed graphs
+// give their weak components.
+struct componentsResult {
+    std::vector<int> labels;
+    std::vector<int> sizes; // Vertices of each component, largest first
+    int numComponents = 0;
+    long long edges = 0;    // Edges of the graph (numerator of TEPS)
+    int merges = 0;         // Components joined by the union-find pass
+};
+
+// Connected components with params.numThreads workers on params.algType
+// deques. SIMPLE runs sequentialComponents.
+componentsResult components(graph& g, Report& report, ws::Params& params);
+
+// One depth-first search per component on one thread. Baseline of
+// CONNECTED_COMPONENTS.
+componentsResult sequentialComponents(graph& g, Report& report);
+
+// Checks that every edge stays inside a component, that every component is
+// connected and that the sizes add up.
+bool validateComponents(graph& g, const componentsResult& result);
+
+// Shape of the tree explored by a UTS run.
+struct utsResult {
+    long long nodes = 0;
+    long long leaves = 0;
+    int maxDepth = 0;
+};
+
+// Explores the UTS tree of params with params.numThreads workers of the
+// fork-join scheduler over params.algType deques. SIMPLE runs
+// sequentialUts. Every run of the same params explores the same tree.
+utsResult uts(Report& report, ws::Params& params);
+
+// Depth-first exploration with a plain stack on one thread. Baseline of UTS.
+utsResult sequentialUts(Report& report, ws::Params& params);
+
 workStealingAlgorithm* workStealingAlgorithmFactory(AlgorithmType algType, int capacity, int numThreads);
 
+// One deque of params.algType per worker.
+std::vector<workStealingAlgorithm*> makeDeques(ws::Params& params, int capacity);
+
+// Runs func(id) on numThreads threads pinned round-robin to the cores and
+// waits for all of them.
+void runWorkers(int numThreads, const std::function<void(int)>& func);
+
+// One steal attempt on every other deque, starting from a random victim.
+// Returns EMPTY when all of them failed.
+int stealAny(std::vector<workStealingAlgorithm*>& algs, bool special, int id, std::mt19937& rng);
+
 int* stubSpanning(graph& g, int size);
 
 bool inArray(int val, int array[], int size);
@@ -804,14 +1544,81 @@ json compare(json properties);
 
 graph graphFactory(GraphType, int shape, bool directed);
 
-json experiment(ws::Params &params, graph &g);
+// Permutation of the vertices and its inverse.
+struct reordering {
+    std::vector<int> newId; // Indexed by the original id
+    std::vector<int> oldId; // Indexed by the new id
+};
+
+// Computes the order of type for g, with numThreads workers for the
+// per-vertex keys. HILBERT needs one of the tori and throws
+// std::invalid_argument for any other graph.
+reordering vertexOrder(graph& g, ReorderType type, int numThreads = 1);
+
+// Copy of g with every vertex v renamed order.newId[v], root included.
+graph relabel(graph& g, const reordering& order);
+
+// Per-vertex values of a relabeled graph, indexed by the original ids.
+std::vector<int> toOriginal(const reordering& order, const std::vector<int>& values);
+
+// Same as toOriginal for values that are vertices (parents); negative
+// values (BOTTOM) are kept.
+std::vector<int> verticesToOriginal(const reordering& order, const std::vector<int>& vertices);
+
+// Largest |u - v| over the edges; the smaller, the closer the neighbours.
+int bandwidth(graph& g);
+
+json experiment(ws::Params &params, graph &g, tracer* trace = nullptr);
 
-json experimentComplete(GraphType type, int shape, bool directed);
+// Runs params.numWarmUps discarded experiments followed by
+// params.numIterExps measured ones and summarizes every metric.
+json experimentStatistics(ws::Params &params, graph &g);
+
+// Min, median, mean, standard deviation and 95% confidence interval of
+// the mean (Student's t) of a sample.
+json summarize(std::vector<double> values);
+
+// Runs the SIMPLE algorithm with the repetitions of params.
+json baselineStatistics(ws::Params params, graph &g);
+
+// Adds speedup, parallel efficiency and work inflation of result
+// (experiment or experimentStatistics output) relative to the SIMPLE
+// baseline. A zero-cost result gets its overhead instead.
+void addBaselineMetrics(json& result, const json& baseline);
+
+// Streams one JSON line per configuration to out as soon as it finishes.
+void experimentComplete(GraphType type, int shape, bool directed, std::ostream& out = std::cout);
 
 std::unordered_map<AlgorithmType, std::vector<json>> buildLists();
 
 std::string getAlgorithmTypeFromEnum(AlgorithmType type);
 
+json environmentFingerprint();
+
+AlgorithmType getAlgorithmTypeFromString(std::string type);
+
+GraphType getGraphTypeFromString(std::string type);
+
+std::string getGraphTypeFromEnum(GraphType type);
+
+std::string getReorderTypeFromEnum(ReorderType type);
+
+ReorderType getReorderTypeFromString(std::string type);
+
+std::string getWorkloadTypeFromEnum(WorkloadType type);
+
+WorkloadType getWorkloadTypeFromString(std::string type);
+
+std::string getUtsTreeTypeFromEnum(UtsTreeType type);
+
+UtsTreeType getUtsTreeTypeFromString(std::string type);
+
+bool isSpecial(AlgorithmType type);
+
+// Whether every task put in a deque of this type is taken or stolen exactly
+// once; false for the multiplicity and idempotent deques.
+bool handsOutOnce(AlgorithmType type);
+
 
 // class MemManager {
 //     void register_thread(int num); // Called once, before any call to op_begin(), num indicate the maximum number of locations the caller can reserve
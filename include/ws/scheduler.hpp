@@ -0,0 +1,296 @@
+#pragma once
+#ifndef _SCHEDULER_HPP_
+#define _SCHEDULER_HPP_
+
+#include "ws/lib.hpp"
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <new>
+#include <random>
+#include <type_traits>
+#include <utility>
+
+namespace ws {
+
+//////////////////////////////
+// Fork-join task scheduler //
+//////////////////////////////
+
+// Tasks live in a slab preallocated per worker; the deques only carry the
+// index of the slot. Algorithms with multiplicity (or idempotent ones) may
+// hand the same index to several workers, so a slot is claimed with a CAS
+// before running and duplicates are dropped.
+
+class TaskGroup;
+class Scheduler;
+
+struct TaskSlot {
+    // Closures larger than this are rejected at compile time; capture
+    // big state by reference.
+    static constexpr std::size_t BUFFER_SIZE = 64;
+
+    enum State { FREE, READY, RUNNING };
+
+    alignas(std::max_align_t) unsigned char buffer[BUFFER_SIZE];
+    void (*run)(void*) = nullptr; // Invokes and destroys the closure
+    TaskGroup* group = nullptr;   // nullptr for coroutine resumptions
+    std::atomic<int> state = FREE;
+    int next = -1;                // Link in the remote free list
+};
+
+struct SchedulerStats {
+    long long spawns = 0;
+    long long inlined = 0;    // Spawns run in place because the slab was full
+    long long executed = 0;
+    long long steals = 0;
+    long long duplicates = 0; // Indexes whose slot was already claimed
+};
+
+class Scheduler {
+public:
+    Scheduler(AlgorithmType algType, int numThreads, int tasksPerWorker = 4096,
+              int dequeCapacity = 1 << 20);
+
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    // Runs root on the calling thread as worker 0 while the other workers
+    // steal; returns once root has returned and every worker is parked.
+    template <typename F>
+    void run(F&& root);
+
+    int numWorkers() const { return numThreads_; }
+
+    AlgorithmType algorithm() const { return algType_; }
+
+    SchedulerStats stats() const;
+
+    // Pushes the resumption of handle on the calling worker's deque, where
+    // thieves can take it. Returns false when the worker has no free slot.
+    bool schedule(std::coroutine_handle<> handle);
+
+    // Runs tasks on the calling worker until done() holds.
+    template <typename P>
+    void helpUntil(P done);
+
+    // Whether the calling worker's deque has nothing left to steal.
+    bool localEmpty();
+
+    // Index of the calling worker, -1 outside of run.
+    static int workerId();
+
+    // Scheduler the calling thread is working for, nullptr outside of run.
+    static Scheduler* current();
+
+private:
+    friend class TaskGroup;
+
+    struct Worker {
+        workStealingAlgorithm* deque = nullptr;
+        TaskSlot* slots = nullptr;
+        std::vector<int> freeSlots;
+        std::atomic<int> remoteFree = -1;
+        std::mt19937 rng;
+        SchedulerStats stats;
+    };
+
+    AlgorithmType algType_;
+    bool special_;
+    int numThreads_;
+    int tasksPerWorker_;
+    std::unique_ptr<Worker[]> workers_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable parked_;
+    long long epoch_ = 0;
+    int numParked_ = 0;
+    bool shutdown_ = false;
+    std::atomic<bool> active_ = false;
+
+    template <typename F>
+    bool trySpawn(TaskGroup* group, F&& f);
+
+    void begin();
+
+    void end();
+
+    void workerLoop(int id);
+
+    int allocate(int id);
+
+    void freeSlot(int index, int id);
+
+    void push(int id, int index);
+
+    int pop(int id);
+
+    int stealFrom(int id);
+
+    // Runs the task behind index unless another worker already claimed it.
+    bool execute(int index, int id);
+
+    // Runs one task (own deque first, then a random victim).
+    bool runOne(int id);
+};
+
+// Tasks spawned through a group may run on any worker; sync runs other
+// tasks while waiting, so it can be called from inside a task.
+class TaskGroup {
+public:
+    TaskGroup();
+
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    template <typename F>
+    void spawn(F&& f);
+
+    void sync();
+
+private:
+    friend class Scheduler;
+
+    Scheduler* scheduler_;
+    std::atomic<int> pending_ = 0;
+};
+
+template <typename F>
+void Scheduler::run(F&& root)
+{
+    begin();
+    try {
+        root();
+    } catch (...) {
+        end();
+        throw;
+    }
+    end();
+}
+
+template <typename P>
+void Scheduler::helpUntil(P done)
+{
+    int id = workerId();
+    while (!done()) {
+        if (!runOne(id)) std::this_thread::yield();
+    }
+}
+
+template <typename F>
+bool Scheduler::trySpawn(TaskGroup* group, F&& f)
+{
+    using Closure = std::decay_t<F>;
+    static_assert(sizeof(Closure) <= TaskSlot::BUFFER_SIZE,
+                  "closure too large for a task slot, capture by reference");
+    static_assert(alignof(Closure) <= alignof(std::max_align_t),
+                  "closure over-aligned for a task slot");
+    int id = workerId();
+    Worker& w = workers_[id];
+    w.stats.spawns++;
+    int index = allocate(id);
+    if (index < 0) {
+        w.stats.inlined++;
+        return false;
+    }
+    TaskSlot& slot = w.slots[index % tasksPerWorker_];
+    ::new (static_cast<void*>(slot.buffer)) Closure(std::forward<F>(f));
+    slot.run = [](void* buffer) {
+        Closure* c = std::launder(reinterpret_cast<Closure*>(buffer));
+        (*c)();
+        c->~Closure();
+    };
+    slot.group = group;
+    slot.state.store(TaskSlot::READY, release);
+    push(id, index);
+    return true;
+}
+
+template <typename F>
+void TaskGroup::spawn(F&& f)
+{
+    // Counted before the task is published, a thief may finish it at once.
+    pending_.fetch_add(1, relaxed);
+    if (!scheduler_->trySpawn(this, std::forward<F>(f))) {
+        pending_.fetch_sub(1, relaxed);
+        f();
+    }
+}
+
+/////////////////////////////////////
+// Lazy binary splitting on ranges //
+/////////////////////////////////////
+
+// A range is only split when the worker's own deque is empty, i.e. when
+// some thief could use the other half. No grain size to tune: without
+// thieves around, a range runs as a plain loop after log(n) splits.
+
+template <typename F>
+void lazyFor(Scheduler& s, int begin, int end, F& body)
+{
+    while (begin < end) {
+        if (end - begin > 1 && s.localEmpty()) {
+            int middle = begin + (end - begin) / 2;
+            TaskGroup g;
+            g.spawn([&s, middle, end, &body]() { lazyFor(s, middle, end, body); });
+            lazyFor(s, begin, middle, body);
+            g.sync();
+            return;
+        }
+        body(begin++);
+    }
+}
+
+template <typename T, typename M, typename C>
+T lazyReduce(Scheduler& s, int begin, int end, const T& identity, M& map, C& combine)
+{
+    T acc = identity;
+    while (begin < end) {
+        if (end - begin > 1 && s.localEmpty()) {
+            int middle = begin + (end - begin) / 2;
+            T right = identity;
+            TaskGroup g;
+            g.spawn([&]() { right = lazyReduce(s, middle, end, identity, map, combine); });
+            T left = lazyReduce(s, begin, middle, identity, map, combine);
+            g.sync();
+            return combine(combine(acc, left), right);
+        }
+        acc = combine(acc, map(begin++));
+    }
+    return acc;
+}
+
+// Calls body(i) for every i in [begin, end). Called from outside a run of
+// s, it starts one.
+template <typename F>
+void parallelFor(Scheduler& s, int begin, int end, F body)
+{
+    if (Scheduler::current() == &s) {
+        lazyFor(s, begin, end, body);
+    } else {
+        s.run([&]() { lazyFor(s, begin, end, body); });
+    }
+}
+
+// Folds map(i) over [begin, end) with combine, which must be associative;
+// the order of the operands is kept.
+template <typename T, typename M, typename C>
+T parallelReduce(Scheduler& s, int begin, int end, T identity, M map, C combine)
+{
+    if (Scheduler::current() == &s) {
+        return lazyReduce(s, begin, end, identity, map, combine);
+    }
+    T result = identity;
+    s.run([&]() { result = lazyReduce(s, begin, end, identity, map, combine); });
+    return result;
+}
+
+} // namespace ws
+
+#endif /* _SCHEDULER_HPP_ */
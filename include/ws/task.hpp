@@ -0,0 +1,229 @@
+#pragma once
+#ifndef _TASK_HPP_
+#define _TASK_HPP_
+
+#include "ws/scheduler.hpp"
+#include <coroutine>
+#include <exception>
+#include <optional>
+
+namespace ws {
+
+/////////////////////
+// Coroutine tasks //
+/////////////////////
+
+// ws::task<T> is lazy: nothing runs until it is awaited, spawned or passed
+// to syncWait. Awaiting a task runs it right away through symmetric
+// transfer. Spawning it gives continuation stealing: the parent's
+// resumption goes to the worker's deque, the worker runs the child, and a
+// thief may resume the parent meanwhile. co_await ws::sync() waits for
+// every spawned child, and the last child to finish resumes the parent.
+//
+//   ws::task<int> fib(int n) {
+//       if (n < 2) co_return n;
+//       ws::task<int> a = fib(n - 1);
+//       co_await ws::spawn(a);
+//       int b = co_await fib(n - 2);
+//       co_await ws::sync();
+//       co_return a.result() + b;
+//   }
+
+template <typename T = void>
+class task;
+
+namespace detail {
+
+struct promiseBase {
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    promiseBase* parent = nullptr;    // Set while the task runs spawned
+    std::atomic<int> joins = 1;       // One for the task plus running children
+    std::atomic<bool> finished = false;
+    std::exception_ptr exception;
+
+    struct finalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept
+        {
+            // Nothing in the frame is touched after the last atomic, the
+            // parent may destroy it right away.
+            promiseBase& p = h.promise();
+            std::coroutine_handle<> next = p.continuation;
+            if (p.parent != nullptr) {
+                if (p.parent->joins.fetch_sub(1, std::memory_order_acq_rel) == 1) return next;
+                return std::noop_coroutine();
+            }
+            p.finished.store(true, release);
+            return next;
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    finalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct promise : promiseBase {
+    std::optional<T> value;
+
+    task<T> get_return_object();
+
+    template <typename U>
+    void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+
+    T& result()
+    {
+        if (exception) std::rethrow_exception(exception);
+        return *value;
+    }
+};
+
+template <>
+struct promise<void> : promiseBase {
+    task<void> get_return_object();
+
+    void return_void() {}
+
+    void result()
+    {
+        if (exception) std::rethrow_exception(exception);
+    }
+};
+
+} // namespace detail
+
+template <typename T>
+class task {
+public:
+    using promise_type = detail::promise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    explicit task(handle_type handle) : handle_(handle) {}
+
+    task(task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+
+    ~task()
+    {
+        if (handle_) handle_.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle_.promise().continuation = awaiting;
+        return handle_;
+    }
+
+    decltype(auto) await_resume() { return handle_.promise().result(); }
+
+    // Value of a finished task (after co_await ws::sync() for spawned ones).
+    decltype(auto) result() { return handle_.promise().result(); }
+
+    handle_type handle() const { return handle_; }
+
+private:
+    handle_type handle_;
+};
+
+namespace detail {
+
+template <typename T>
+task<T> promise<T>::get_return_object()
+{
+    return task<T>(std::coroutine_handle<promise<T>>::from_promise(*this));
+}
+
+inline task<void> promise<void>::get_return_object()
+{
+    return task<void>(std::coroutine_handle<promise<void>>::from_promise(*this));
+}
+
+template <typename T>
+struct spawnAwaiter {
+    task<T>& child;
+
+    bool await_ready() const noexcept { return false; }
+
+    template <typename P>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<P> parent)
+    {
+        promiseBase& pp = parent.promise();
+        std::coroutine_handle<promise<T>> c = child.handle();
+        promise<T>& cp = c.promise();
+        cp.parent = &pp;
+        cp.continuation = parent;
+        pp.joins.fetch_add(1, relaxed);
+        // Once published a thief may resume the parent: this awaiter lives
+        // in its frame, so only locals are used from here on.
+        if (!Scheduler::current()->schedule(parent)) {
+            // No free slot, run the child as a plain call instead.
+            pp.joins.fetch_sub(1, relaxed);
+            cp.parent = nullptr;
+        }
+        return c;
+    }
+
+    void await_resume() const noexcept {}
+};
+
+struct syncAwaiter {
+    promiseBase* promise_ = nullptr;
+
+    bool await_ready() const noexcept { return false; }
+
+    template <typename P>
+    bool await_suspend(std::coroutine_handle<P> h) noexcept
+    {
+        promise_ = &h.promise();
+        return promise_->joins.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+    // Every child has finished: restore the token for the next round.
+    void await_resume() const noexcept { promise_->joins.store(1, relaxed); }
+};
+
+} // namespace detail
+
+// Starts child now and lets thieves take the rest of the calling coroutine.
+template <typename T>
+detail::spawnAwaiter<T> spawn(task<T>& child)
+{
+    return detail::spawnAwaiter<T>{child};
+}
+
+// Waits for every child spawned by the calling coroutine.
+inline detail::syncAwaiter sync()
+{
+    return {};
+}
+
+// Runs t on s (the calling thread acts as worker 0) and returns its value.
+template <typename T>
+T syncWait(Scheduler& s, task<T> t)
+{
+    auto h = t.handle();
+    s.run([&]() {
+        h.resume();
+        s.helpUntil([&]() { return h.promise().finished.load(acquire); });
+    });
+    if constexpr (std::is_void_v<T>) {
+        t.result();
+    } else {
+        return std::move(t.result());
+    }
+}
+
+} // namespace ws
+
+#endif /* _TASK_HPP_ */
@@ -0,0 +1,357 @@
+#include "ws/lib.hpp"
+#include "ws/scheduler.hpp"
+#include <random>
+
+//////////////////////////
+// Breadth-first search //
+//////////////////////////
+
+// Three parallel versions share the deques of params.algType:
+//
+// - BFS_WS relaxes vertices in any order straight from the deques
+//   (label-correcting), like the spanning tree but keeping distances.
+// - BFS_TOP_DOWN expands one level at a time; each level is cut in chunks
+//   of the frontier that the workers take and steal.
+// - BFS_DIRECTION_OPT also goes bottom-up (unvisited vertices look for a
+//   parent in the frontier) on the big levels, following Beamer, Asanovic
+//   and Patterson, "Direction-Optimizing Breadth-First Search".
+
+namespace {
+
+const int BFS_CHUNK = 64; // Vertices per task in the level-synchronous versions
+const int BFS_ALPHA = 14; // Go bottom-up when the frontier edges exceed unexplored / alpha
+const int BFS_BETA = 24;  // and back top-down when the frontier is below n / beta
+
+// Edges that reach v: the predecessors of directed graphs are stored as
+// children.
+std::list<int>& incoming(graph& g, int v)
+{
+    return g.isDirected() ? g.getChildren(v) : g.getNeighbours(v);
+}
+
+long long componentEdges(graph& g, const std::vector<int>& distances)
+{
+    long long edges = 0;
+    for (int v = 0; v < g.getNumberVertices(); v++) {
+        if (distances[v] >= 0) edges += g.getNeighbours(v).size();
+    }
+    // Undirected edges are stored in both directions
+    return g.isDirected() ? edges : edges / 2;
+}
+
+void finish(graph& g, bfsResult& result)
+{
+    result.edges = componentEdges(g, result.distances);
+    result.levels = *std::max_element(result.distances.begin(), result.distances.end());
+}
+
+struct bfsCounters {
+    int takes = 0;
+    int puts = 0;
+    int steals = 0;
+    int expansions = 0;
+
+    void addTo(Report& report, int id)
+    {
+        report.takes += takes;
+        report.puts += puts;
+        report.steals += steals;
+        report.expansions += expansions;
+        report.processors_[id] = expansions;
+    }
+};
+
+bfsResult asyncBfs(graph& g, int root, Report& report, ws::Params& params)
+{
+    const int n = g.getNumberVertices();
+    const bool special = isSpecial(params.algType);
+    std::unique_ptr<std::atomic<int>[]> distances(new std::atomic<int>[n]);
+    std::unique_ptr<std::atomic<bool>[]> queued(new std::atomic<bool>[n]);
+    bfsResult result;
+    result.distances.assign(n, -1);
+    result.parents.assign(n, BOTTOM);
+    ws::Scheduler aux(params.algType, params.numThreads, 64, 4096);
+    ws::parallelFor(aux, 0, n, [&](int v) {
+        distances[v].store(-1, relaxed);
+        queued[v].store(false, relaxed);
+    });
+    // Vertices are queued again when their distance improves
+    std::vector<workStealingAlgorithm*> algs = makeDeques(params, std::max(params.structSize, 2 * n));
+    std::atomic<int> pending = 1; // Queued vertices not yet expanded
+    distances[root] = 0;
+    queued[root] = true;
+    dequeHandle(algs[0], special, 0).put(root);
+    report.puts++;
+    report.processors_ = new int[params.numThreads](); // Vertices expanded by each worker
+    auto t_start = std::chrono::high_resolution_clock::now();
+    runWorkers(params.numThreads, [&](int id) {
+        dequeHandle own(algs[id], special, id);
+        std::mt19937 rng(id + 1);
+        bfsCounters c;
+        while (true) {
+            int v = own.take();
+            if (v >= 0) {
+                c.takes++;
+            } else {
+                v = stealAny(algs, special, id, rng);
+                if (v >= 0) c.steals++;
+            }
+            if (v < 0) {
+                // Only workers holding a vertex can queue more
+                if (pending.load() == 0) break;
+                std::this_thread::yield();
+                continue;
+            }
+            // Copies handed out by the deques with multiplicity
+            if (!queued[v].exchange(false)) continue;
+            c.expansions++;
+            int d = distances[v].load() + 1;
+            for (int u : g.getNeighbours(v)) {
+                int current = distances[u].load(relaxed);
+                bool improved = false;
+                while (current < 0 || d < current) {
+                    if (distances[u].compare_exchange_weak(current, d)) {
+                        improved = true;
+                        break;
+                    }
+                }
+                if (improved && !queued[u].exchange(true)) {
+                    pending.fetch_add(1);
+                    own.put(u);
+                    c.puts++;
+                }
+            }
+            pending.fetch_sub(1);
+        }
+        c.addTo(report, id);
+    });
+    // Only the traversal is timed. The level-synchronous BFS writes parents
+    // as it claims vertices, but here a vertex can be improved after its
+    // parent was written, so they follow from the final distances in a
+    // pass of their own, reported apart as parentsTime.
+    auto t_end = std::chrono::high_resolution_clock::now();
+    report.executionTime = std::chrono::duration<long, std::nano>(t_end - t_start).count();
+    ws::parallelFor(aux, 0, n, [&](int v) {
+        int d = distances[v].load(relaxed);
+        result.distances[v] = d;
+        if (d <= 0) return;
+        for (int u : incoming(g, v)) {
+            if (distances[u].load(relaxed) == d - 1) {
+                result.parents[v] = u;
+                break;
+            }
+        }
+    });
+    result.parentsTime = std::chrono::duration<long, std::nano>(std::chrono::high_resolution_clock::now() - t_end).count();
+    for (auto alg : algs) delete alg;
+    finish(g, result);
+    return result;
+}
+
+bfsResult levelBfs(graph& g, int root, Report& report, ws::Params& params, bool directionOptimizing)
+{
+    const int n = g.getNumberVertices();
+    const int numThreads = params.numThreads;
+    const bool special = isSpecial(params.algType);
+    std::unique_ptr<std::atomic<int>[]> distances(new std::atomic<int>[n]);
+    bfsResult result;
+    result.distances.assign(n, -1);
+    result.parents.assign(n, BOTTOM);
+    ws::Scheduler aux(params.algType, numThreads, 64, 4096);
+    ws::parallelFor(aux, 0, n, [&](int v) { distances[v].store(-1, relaxed); });
+    std::vector<workStealingAlgorithm*> algs = makeDeques(params, std::max(params.structSize, n / BFS_CHUNK + numThreads));
+
+    // Only changed by the completion step of the barrier, while every
+    // worker is waiting on it.
+    std::vector<int> frontier;
+    frontier.reserve(n);
+    std::vector<char> inFrontier(n, 0); // Bitmap of the frontier for bottom-up levels
+    std::vector<std::vector<int>> next(numThreads);
+    bool bottomUp = false;
+    bool bitmapSet = false;
+    bool done = false;
+    int level = 0;
+    long long unexplored = 0; // Edges of unvisited vertices (mu in Beamer et al.)
+    for (int v = 0; v < n; v++) unexplored += g.getNeighbours(v).size();
+
+    auto nextLevel = [&]() noexcept {
+        if (bitmapSet) {
+            for (int v : frontier) inFrontier[v] = 0;
+            bitmapSet = false;
+        }
+        frontier.clear();
+        long long frontierEdges = 0;
+        for (auto& local : next) {
+            for (int v : local) {
+                frontier.emplace_back(v);
+                frontierEdges += g.getNeighbours(v).size();
+            }
+            local.clear();
+        }
+        level++;
+        unexplored -= frontierEdges;
+        if (frontier.empty()) {
+            done = true;
+            return;
+        }
+        if (directionOptimizing) {
+            if (!bottomUp && frontierEdges > unexplored / BFS_ALPHA) {
+                bottomUp = true;
+            } else if (bottomUp && static_cast<long long>(frontier.size()) < n / BFS_BETA) {
+                bottomUp = false;
+            }
+        }
+        if (bottomUp) {
+            for (int v : frontier) inFrontier[v] = 1;
+            bitmapSet = true;
+            result.bottomUpLevels++;
+        }
+    };
+    std::barrier levelDone(numThreads, nextLevel);
+
+    distances[root] = 0;
+    frontier.emplace_back(root);
+    unexplored -= g.getNeighbours(root).size();
+    report.processors_ = new int[numThreads](); // Vertices expanded by each worker
+    auto t_start = std::chrono::high_resolution_clock::now();
+    runWorkers(numThreads, [&](int id) {
+        dequeHandle own(algs[id], special, id);
+        std::mt19937 rng(id + 1);
+        bfsCounters c;
+        std::vector<int>& found = next[id];
+        while (!done) {
+            const int d = level + 1;
+            const int items = bottomUp ? n : static_cast<int>(frontier.size());
+            const int chunks = (items + BFS_CHUNK - 1) / BFS_CHUNK;
+            // Each worker starts with a block of chunks, the rest is stealing
+            for (int k = chunks * id / numThreads; k < chunks * (id + 1) / numThreads; k++) {
+                own.put(k);
+                c.puts++;
+            }
+            while (true) {
+                int k = own.take();
+                if (k >= 0) {
+                    c.takes++;
+                } else {
+                    k = stealAny(algs, special, id, rng);
+                    if (k < 0) break;
+                    c.steals++;
+                }
+                int end = std::min(items, (k + 1) * BFS_CHUNK);
+                // Chunks handed out twice are harmless: a vertex is claimed
+                // once, by the CAS on its distance.
+                for (int i = k * BFS_CHUNK; i < end; i++) {
+                    if (bottomUp) {
+                        int v = i;
+                        if (distances[v].load(relaxed) >= 0) continue;
+                        c.expansions++;
+                        for (int u : incoming(g, v)) {
+                            if (!inFrontier[u]) continue;
+                            int unvisited = -1;
+                            if (distances[v].compare_exchange_strong(unvisited, d)) {
+                                result.parents[v] = u;
+                                found.emplace_back(v);
+                            }
+                            break;
+                        }
+                    } else {
+                        int v = frontier[i];
+                        c.expansions++;
+                        for (int u : g.getNeighbours(v)) {
+                            int unvisited = -1;
+                            if (distances[u].load(relaxed) < 0 &&
+                                distances[u].compare_exchange_strong(unvisited, d)) {
+                                result.parents[u] = v;
+                                found.emplace_back(u);
+                            }
+                        }
+                    }
+                }
+            }
+            levelDone.arrive_and_wait();
+        }
+        c.addTo(report, id);
+    });
+    auto t_end = std::chrono::high_resolution_clock::now();
+    report.executionTime = std::chrono::duration<long, std::nano>(t_end - t_start).count();
+    ws::parallelFor(aux, 0, n, [&](int v) { result.distances[v] = distances[v].load(relaxed); });
+    for (auto alg : algs) delete alg;
+    finish(g, result);
+    return result;
+}
+
+}
+
+bfsResult sequentialBfs(graph& g, int root, Report& report)
+{
+    const int n = g.getNumberVertices();
+    bfsResult result;
+    result.distances.assign(n, -1);
+    result.parents.assign(n, BOTTOM);
+    std::vector<int> queue;
+    queue.reserve(n);
+    int puts = 0, takes = 0;
+    auto t_start = std::chrono::high_resolution_clock::now();
+    result.distances[root] = 0;
+    queue.emplace_back(root);
+    puts++;
+    for (size_t head = 0; head < queue.size(); head++) {
+        int v = queue[head];
+        takes++;
+        for (int u : g.getNeighbours(v)) {
+            if (result.distances[u] >= 0) continue;
+            result.distances[u] = result.distances[v] + 1;
+            result.parents[u] = v;
+            queue.emplace_back(u);
+            puts++;
+        }
+    }
+    auto t_end = std::chrono::high_resolution_clock::now();
+    report.executionTime = std::chrono::duration<long, std::nano>(t_end - t_start).count();
+    report.puts = puts;
+    report.takes = takes;
+    report.expansions = takes;
+    int* processors = new int[report.numProcessors_]();
+    processors[0] = takes;
+    report.processors_ = processors;
+    finish(g, result);
+    return result;
+}
+
+bfsResult bfs(graph& g, int root, Report& report, ws::Params& params)
+{
+    if (params.algType == AlgorithmType::SIMPLE) return sequentialBfs(g, root, report);
+    switch (params.workload) {
+    case WorkloadType::BFS_WS:
+        return asyncBfs(g, root, report, params);
+    case WorkloadType::BFS_DIRECTION_OPT:
+        return levelBfs(g, root, report, params, true);
+    case WorkloadType::BFS_TOP_DOWN:
+    default:
+        return levelBfs(g, root, report, params, false);
+    }
+}
+
+bool validateBfs(graph& g, int root, const bfsResult& result)
+{
+    const std::vector<int>& distances = result.distances;
+    const std::vector<int>& parents = result.parents;
+    if (distances[root] != 0 || parents[root] != BOTTOM) return false;
+    for (int v = 0; v < g.getNumberVertices(); v++) {
+        if (distances[v] < 0) {
+            if (parents[v] != BOTTOM) return false;
+            continue;
+        }
+        if (v != root) {
+            int p = parents[v];
+            if (p < 0 || distances[p] != distances[v] - 1) return false;
+            std::list<int>& edges = g.getNeighbours(p);
+            if (std::find(edges.begin(), edges.end(), v) == edges.end()) return false;
+        }
+        // Every edge leaving a reached vertex spans at most one level
+        for (int u : g.getNeighbours(v)) {
+            if (distances[u] < 0 || distances[u] > distances[v] + 1) return false;
+        }
+    }
+    return true;
+}
@@ -7,20 +7,24 @@
 // We're following the description provided by Morrison and Afek from
 // the article "Fence-Free Work Stealing on Bounded TSO Processors" to
 // implement Chase-Lev work-stealing algorithm
-chaselev::chaselev(int initialSize) : tasks(new std::atomic<int>[initialSize]){
+template <OwnerFence F>
+basicChaseLev<F>::basicChaseLev(int initialSize, int delta)
+    : tasks(new std::atomic<int>[initialSize]), delta(F == DELTA_GAP ? delta : 0) {
     H = 0;
     T = 0;
     tasksSize = initialSize;
     std::fill(tasks.get(), tasks.get() + initialSize, BOTTOM);
 }
 
-bool chaselev::isEmpty() {
+template <OwnerFence F>
+bool basicChaseLev<F>::isEmpty() {
     int tail = T.load();
     int head = H.load();
     return head >= tail;
 }
 
-void chaselev::expand() {
+template <OwnerFence F>
+void basicChaseLev<F>::expand() {
     int newSize = 2 * tasksSize;
     auto *newData = new std::atomic<int>[newSize];
     for (int i = 0; i < tasksSize; i++) newData[i] = tasks[i].load();
@@ -28,26 +32,52 @@ void chaselev::expand() {
     tasksSize = newSize;
 }
 
-bool chaselev::put(int task) {
+template <OwnerFence F>
+bool basicChaseLev<F>::put(int task) {
     int tail = T.load();
     if (tail == tasksSize) {
         expand();
         return put(task);
     }
+    if constexpr (F != FULL_FENCE) {
+        // Release is enough to publish the task with T (no fence on TSO)
+        tasks[mod(tail, tasksSize)].store(task, release);
+        T.store(tail + 1, release);
+        return true;
+    }
     tasks[mod(tail, tasksSize)] = task;
     std::atomic_thread_fence(seq_cst);
     T.store(tail + 1);
     return true;
 }
 
-int chaselev::take() {
+template <OwnerFence F>
+int basicChaseLev<F>::take() {
     int tail = T.load() - 1;
-    T.store(tail);
-    // In C++, the language doesn't have support for StoreLoad
-    // fence. But using atomic thread fence with memory_order_seq_cst,
-    // it's possible that compiler would add MFENCE fence.
-    std::atomic_thread_fence(seq_cst);
-    int h = H.load();
+    int h;
+    if constexpr (F == DELTA_GAP) {
+        T.store(tail, release);
+        ownerFence<F>();
+        h = H.load();
+        // Thieves stop delta tasks below the T they see, which is at most
+        // delta above this one, so they never reach tail.
+        if (tail > h) return tasks[mod(tail, tasksSize)];
+        // Last task or empty: fenced as usual
+        std::atomic_thread_fence(seq_cst);
+        h = H.load();
+    } else if constexpr (F == MEMBARRIER) {
+        // The membarrier of a thief acts as this take's fence
+        T.store(tail, release);
+        ownerFence<F>();
+        h = H.load();
+    } else {
+        T.store(tail);
+        // In C++, the language doesn't have support for StoreLoad
+        // fence. But using atomic thread fence with memory_order_seq_cst,
+        // it's possible that compiler would add MFENCE fence.
+        std::atomic_thread_fence(seq_cst);
+        h = H.load();
+    }
     if (tail > h) return tasks[mod(tail, tasksSize)];
     if (tail < h) {
         T.store(h);
@@ -61,12 +91,13 @@ int chaselev::take() {
     }
 }
 
-int chaselev::steal() {
+template <OwnerFence F>
+int basicChaseLev<F>::steal() {
     while (true) {
         int h = H.load();
-        std::atomic_thread_fence(seq_cst);
+        thiefFence<F>();
         int t = T.load();
-        if (h >= t) return EMPTY;
+        if (h + delta >= t) return EMPTY;
         int task = tasks[mod(h, tasksSize)];
         if (!H.compare_exchange_strong(h, h + 1, seq_cst, relaxed)) {
             continue;
@@ -75,6 +106,11 @@ int chaselev::steal() {
     }
 }
 
-int chaselev::getSize() {
+template <OwnerFence F>
+int basicChaseLev<F>::getSize() {
     return tasksSize;
 }
+
+template class basicChaseLev<FULL_FENCE>;
+template class basicChaseLev<DELTA_GAP>;
+template class basicChaseLev<MEMBARRIER>;
@@ -4,20 +4,24 @@
 // Cilk work-stealing algorithm //
 //////////////////////////////////
 
-cilk::cilk(int initialSize) : tasks (new std::atomic<int>[initialSize]) {
+template <typename Lock, OwnerFence F>
+basicCilk<Lock, F>::basicCilk(int initialSize, int delta)
+    : tasks (new std::atomic<int>[initialSize]), delta(F == DELTA_GAP ? delta : 0) {
     H = 0;
     T = 0;
     tasksSize = initialSize;
     std::fill(tasks.get(), tasks.get() + initialSize, BOTTOM);
 }
 
-bool cilk::isEmpty() {
+template <typename Lock, OwnerFence F>
+bool basicCilk<Lock, F>::isEmpty() {
     int tail = T.load();
     int head = H.load();
     return head >= tail;
 }
 
-void cilk::expand() {
+template <typename Lock, OwnerFence F>
+void basicCilk<Lock, F>::expand() {
     int newSize = 2 * tasksSize;
     auto *newData = new std::atomic<int>[newSize];
     for (int i = 0; i < tasksSize; i++) newData[i] = tasks[i].load();
@@ -25,11 +29,13 @@ void cilk::expand() {
     tasksSize = newSize;
 }
 
-int cilk::getSize() {
+template <typename Lock, OwnerFence F>
+int basicCilk<Lock, F>::getSize() {
     return tasksSize;
 }
 
-bool cilk::put(int task) {
+template <typename Lock, OwnerFence F>
+bool basicCilk<Lock, F>::put(int task) {
     int tail = T.load(relaxed);
     if (tail == tasksSize) {
         expand();
@@ -41,15 +47,20 @@ bool cilk::put(int task) {
     return true;
 }
 
-int cilk::take() {
+template <typename Lock, OwnerFence F>
+int basicCilk<Lock, F>::take() {
     int tail = T.load(relaxed) - 1;
     T.store(tail, relaxed);
-    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // With DELTA_GAP thieves stay delta below the T they see, so they
+    // cannot reach tail even while this store is still buffered.
+    // With MEMBARRIER the thieves fence for the owner.
+    ownerFence<F>();
     int head = H.load(relaxed);
 
     if (tail > head) return tasks[mod(tail, tasksSize)];
     if (tail < head) {
-        const std::lock_guard<std::mutex> lock(mtx);
+        // The owner has to know the outcome, so it waits for the lock
+        const std::lock_guard<Lock> lock(mtx);
         if (H.load() >= (tail + 1)) {
             T.store(tail + 1, relaxed);
             return EMPTY;
@@ -58,13 +69,17 @@ int cilk::take() {
     return tasks[mod(tail, tasksSize)];
 }
 
-int cilk::steal() {
+template <typename Lock, OwnerFence F>
+int basicCilk<Lock, F>::steal() {
     int ret;
-    const std::lock_guard<std::mutex> lock(mtx);
+    // A busy lock means another thief (or the owner on the last task) is
+    // at this deque: better to try another victim than to queue behind it.
+    std::unique_lock<Lock> lock(mtx, std::try_to_lock);
+    if (!lock.owns_lock()) return ABORT;
     int h = H.load(relaxed);
     H.store(h + 1, relaxed);
-    std::atomic_thread_fence(seq_cst);
-    if ((h + 1) <= T.load(acquire)) {
+    thiefFence<F>();
+    if ((h + 1) + delta <= T.load(acquire)) {
         ret = tasks[mod(h, tasksSize)];
     } else {
         H.store(h, relaxed);
@@ -72,3 +87,42 @@ int cilk::steal() {
     }
     return ret;
 }
+
+template class basicCilk<std::mutex>;
+template class basicCilk<ttasLock>;
+template class basicCilk<ticketLock>;
+template class basicCilk<mcsLock>;
+template class basicCilk<std::mutex, DELTA_GAP>;
+template class basicCilk<std::mutex, MEMBARRIER>;
+
+void mcsLock::lock()
+{
+    node& n = own();
+    n.next.store(nullptr, relaxed);
+    n.locked.store(true, relaxed);
+    node* prev = tail_.exchange(&n, std::memory_order_acq_rel);
+    if (prev == nullptr) return;
+    prev->next.store(&n, release);
+    while (n.locked.load(acquire)) cpuRelax();
+}
+
+bool mcsLock::try_lock()
+{
+    node& n = own();
+    n.next.store(nullptr, relaxed);
+    node* expected = nullptr;
+    return tail_.compare_exchange_strong(expected, &n, std::memory_order_acq_rel, relaxed);
+}
+
+void mcsLock::unlock()
+{
+    node& n = own();
+    node* next = n.next.load(acquire);
+    if (next == nullptr) {
+        node* expected = &n;
+        if (tail_.compare_exchange_strong(expected, nullptr, release, relaxed)) return;
+        // A waiter swapped the tail but has not linked itself yet
+        while ((next = n.next.load(acquire)) == nullptr) cpuRelax();
+    }
+    next->locked.store(false, release);
+}
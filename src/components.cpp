@@ -0,0 +1,249 @@
+#include "ws/lib.hpp"
+#include "ws/scheduler.hpp"
+#include <random>
+
+//////////////////////////
+// Connected components //
+//////////////////////////
+
+// Unlike the traversals, nothing starts from the root: every vertex is
+// queued once with its own index as label, and the workers lower the labels
+// of the neighbours (label propagation) until the deques drain, so forests
+// and isolated vertices finish like everything else. Labels only move along
+// stored edges, which on directed graphs leaves the weak components split;
+// a union-find pass over the edges merges what remains. Every component
+// ends labelled with its smallest vertex.
+
+namespace {
+
+long long totalEdges(graph& g)
+{
+    // Undirected edges are stored in both directions
+    return g.isDirected() ? g.getNumberEdges() : g.getNumberEdges() / 2;
+}
+
+// Root of v, halving the path on the way.
+int find(std::atomic<int>* parents, int v)
+{
+    while (true) {
+        int p = parents[v].load(relaxed);
+        if (p == v) return v;
+        int gp = parents[p].load(relaxed);
+        if (p != gp) parents[v].compare_exchange_weak(p, gp, relaxed);
+        v = gp;
+    }
+}
+
+// Links the larger root under the smaller one, so parents never point to a
+// larger index and the walks of find always end. Returns whether the
+// components were different.
+bool unite(std::atomic<int>* parents, int a, int b)
+{
+    while (true) {
+        a = find(parents, a);
+        b = find(parents, b);
+        if (a == b) return false;
+        if (a < b) std::swap(a, b);
+        int expected = a;
+        if (parents[a].compare_exchange_strong(expected, b)) return true;
+    }
+}
+
+void summarizeLabels(componentsResult& result)
+{
+    const int n = static_cast<int>(result.labels.size());
+    std::vector<int> counts(n, 0);
+    for (int v = 0; v < n; v++) counts[result.labels[v]]++;
+    result.sizes.clear();
+    for (int v = 0; v < n; v++) {
+        if (result.labels[v] == v) result.sizes.emplace_back(counts[v]);
+    }
+    std::sort(result.sizes.begin(), result.sizes.end(), std::greater<int>());
+    result.numComponents = static_cast<int>(result.sizes.size());
+}
+
+componentsResult parallelComponents(graph& g, Report& report, ws::Params& params)
+{
+    const int n = g.getNumberVertices();
+    const int numThreads = params.numThreads;
+    const bool special = isSpecial(params.algType);
+    std::unique_ptr<std::atomic<int>[]> labels(new std::atomic<int>[n]);
+    std::unique_ptr<std::atomic<bool>[]> queued(new std::atomic<bool>[n]);
+    componentsResult result;
+    result.labels.assign(n, -1);
+    result.edges = totalEdges(g);
+    ws::Scheduler aux(params.algType, numThreads, 64, 4096);
+    ws::parallelFor(aux, 0, n, [&](int v) {
+        labels[v].store(v, relaxed);
+        queued[v].store(true, relaxed);
+    });
+    // Vertices are queued again when their label drops
+    std::vector<workStealingAlgorithm*> algs = makeDeques(params, std::max(params.structSize, 2 * n));
+    std::atomic<int> pending = n; // Queued vertices not yet expanded
+    std::atomic<int> merges = 0;
+    report.processors_ = new int[numThreads](); // Vertices expanded by each worker
+    auto t_start = std::chrono::high_resolution_clock::now();
+    runWorkers(numThreads, [&](int id) {
+        dequeHandle own(algs[id], special, id);
+        std::mt19937 rng(id + 1);
+        int takes = 0, puts = 0, steals = 0, expansions = 0;
+        // Each worker seeds its own block of vertices
+        for (int v = id * (n / numThreads), last = id == numThreads - 1 ? n : (id + 1) * (n / numThreads);
+             v < last; v++) {
+            own.put(v);
+            puts++;
+        }
+        while (true) {
+            int v = own.take();
+            if (v >= 0) {
+                takes++;
+            } else {
+                v = stealAny(algs, special, id, rng);
+                if (v >= 0) steals++;
+            }
+            if (v < 0) {
+                if (pending.load() == 0) break;
+                std::this_thread::yield();
+                continue;
+            }
+            // Copies handed out by the deques with multiplicity
+            if (!queued[v].exchange(false)) continue;
+            expansions++;
+            // A label lowered after this load queues v again
+            int label = labels[v].load();
+            for (int u : g.getNeighbours(v)) {
+                int current = labels[u].load(relaxed);
+                while (label < current) {
+                    if (labels[u].compare_exchange_weak(current, label)) {
+                        if (!queued[u].exchange(true)) {
+                            pending.fetch_add(1);
+                            own.put(u);
+                            puts++;
+                        }
+                        break;
+                    }
+                }
+            }
+            pending.fetch_sub(1);
+        }
+        report.takes += takes;
+        report.puts += puts;
+        report.steals += steals;
+        report.expansions += expansions;
+        report.processors_[id] = expansions;
+    });
+    // Labels point to a smaller vertex of the same component, so they are
+    // already a valid union-find forest.
+    ws::parallelFor(aux, 0, n, [&](int v) {
+        int linked = 0;
+        for (int u : g.getNeighbours(v)) {
+            if (labels[u].load(relaxed) != labels[v].load(relaxed) && unite(labels.get(), v, u)) linked++;
+        }
+        if (linked > 0) merges.fetch_add(linked, relaxed);
+    });
+    ws::parallelFor(aux, 0, n, [&](int v) { result.labels[v] = find(labels.get(), v); });
+    auto t_end = std::chrono::high_resolution_clock::now();
+    report.executionTime = std::chrono::duration<long, std::nano>(t_end - t_start).count();
+    for (auto alg : algs) delete alg;
+    result.merges = merges.load();
+    summarizeLabels(result);
+    return result;
+}
+
+}
+
+componentsResult sequentialComponents(graph& g, Report& report)
+{
+    const int n = g.getNumberVertices();
+    componentsResult result;
+    result.labels.assign(n, -1);
+    result.edges = totalEdges(g);
+    std::vector<int> stack;
+    stack.reserve(n);
+    int puts = 0, takes = 0;
+    auto t_start = std::chrono::high_resolution_clock::now();
+    // Components are found in increasing order of their smallest vertex
+    for (int root = 0; root < n; root++) {
+        if (result.labels[root] >= 0) continue;
+        result.labels[root] = root;
+        stack.emplace_back(root);
+        puts++;
+        while (!stack.empty()) {
+            int v = stack.back();
+            stack.pop_back();
+            takes++;
+            for (int u : g.getNeighbours(v)) {
+                if (result.labels[u] >= 0) continue;
+                result.labels[u] = root;
+                stack.emplace_back(u);
+                puts++;
+            }
+            if (!g.isDirected()) continue;
+            for (int u : g.getChildren(v)) {
+                if (result.labels[u] >= 0) continue;
+                result.labels[u] = root;
+                stack.emplace_back(u);
+                puts++;
+            }
+        }
+    }
+    auto t_end = std::chrono::high_resolution_clock::now();
+    report.executionTime = std::chrono::duration<long, std::nano>(t_end - t_start).count();
+    report.puts = puts;
+    report.takes = takes;
+    report.expansions = takes;
+    int* processors = new int[report.numProcessors_]();
+    processors[0] = takes;
+    report.processors_ = processors;
+    summarizeLabels(result);
+    return result;
+}
+
+componentsResult components(graph& g, Report& report, ws::Params& params)
+{
+    if (params.algType == AlgorithmType::SIMPLE) return sequentialComponents(g, report);
+    return parallelComponents(g, report, params);
+}
+
+bool validateComponents(graph& g, const componentsResult& result)
+{
+    const int n = g.getNumberVertices();
+    const std::vector<int>& labels = result.labels;
+    if (static_cast<int>(labels.size()) != n) return false;
+    std::vector<int> counts(n, 0);
+    for (int v = 0; v < n; v++) {
+        int label = labels[v];
+        // Labels name the smallest vertex of the component, which is its own label
+        if (label < 0 || label > v || labels[label] != label) return false;
+        for (int u : g.getNeighbours(v)) {
+            if (labels[u] != label) return false;
+        }
+        counts[label]++;
+    }
+    // Every label must also be connected: walking from it reaches all of its vertices
+    std::vector<bool> visited(n, false);
+    std::vector<int> stack;
+    std::vector<int> sizes;
+    for (int root = 0; root < n; root++) {
+        if (counts[root] == 0) continue;
+        int reached = 0;
+        visited[root] = true;
+        stack.emplace_back(root);
+        while (!stack.empty()) {
+            int v = stack.back();
+            stack.pop_back();
+            reached++;
+            for (int u : g.getNeighbours(v)) {
+                if (!visited[u]) { visited[u] = true; stack.emplace_back(u); }
+            }
+            if (!g.isDirected()) continue;
+            for (int u : g.getChildren(v)) {
+                if (!visited[u]) { visited[u] = true; stack.emplace_back(u); }
+            }
+        }
+        if (reached != counts[root]) return false;
+        sizes.emplace_back(counts[root]);
+    }
+    std::sort(sizes.begin(), sizes.end(), std::greater<int>());
+    return result.numComponents == static_cast<int>(sizes.size()) && result.sizes == sizes;
+}
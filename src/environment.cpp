@@ -0,0 +1,50 @@
+#include "ws/lib.hpp"
+#include <fstream>
+#include <sys/utsname.h>
+
+#ifndef WS_BUILD_TYPE
+#define WS_BUILD_TYPE "unknown"
+#endif
+
+#ifndef WS_CXX_FLAGS
+#define WS_CXX_FLAGS "unknown"
+#endif
+
+/////////////////////////////
+// Environment fingerprint //
+/////////////////////////////
+
+// Identifies the machine and the build that produced a result, so that
+// numbers coming from different hosts or build types are not mixed.
+json environmentFingerprint()
+{
+    json env;
+    std::string cpuModel = "unknown";
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            auto pos = line.find(':');
+            if (pos != std::string::npos) cpuModel = line.substr(pos + 2);
+            break;
+        }
+    }
+    env["cpuModel"] = cpuModel;
+    env["hardwareConcurrency"] = std::thread::hardware_concurrency();
+    struct utsname info;
+    if (uname(&info) == 0) {
+        env["kernel"] = std::string(info.sysname) + " " + info.release;
+        env["machine"] = info.machine;
+        env["hostname"] = info.nodename;
+    }
+#if defined(__clang__)
+    env["compiler"] = std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    env["compiler"] = std::string("gcc ") + __VERSION__;
+#else
+    env["compiler"] = "unknown";
+#endif
+    env["compilerFlags"] = WS_CXX_FLAGS;
+    env["buildType"] = WS_BUILD_TYPE;
+    return env;
+}
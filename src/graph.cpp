@@ -158,3 +158,20 @@ bool graph::isDirected() {
 void graph::setDirected(bool directed) {
     this->directed = directed;
 }
+
+////////////////////////////////////
+// Adjacency array implementation //
+////////////////////////////////////
+
+adjacencyArray::adjacencyArray(graph& g) : offsets_(g.getNumberVertices() + 1, 0)
+{
+    const int n = g.getNumberVertices();
+    for (int v = 0; v < n; v++) {
+        offsets_[v + 1] = offsets_[v] + static_cast<int>(g.getNeighbours(v).size());
+    }
+    targets_.reserve(offsets_[n]);
+    for (int v = 0; v < n; v++) {
+        std::list<int>& neighbours = g.getNeighbours(v);
+        targets_.insert(targets_.end(), neighbours.begin(), neighbours.end());
+    }
+}
@@ -1,4 +1,5 @@
 #include "ws/lib.hpp"
+#include "ws/scheduler.hpp"
 #include <algorithm>
 #include <iostream>
 #include <stack>
@@ -13,17 +14,36 @@ int suma(int a, int b) {
 
 graph spanningTree(graph& g, int* roots, Report& report, ws::Params& params)
 {
+    if (params.algType == AlgorithmType::SIMPLE) {
+        return sequentialSpanningTree(g, roots[0], report);
+    }
     std::vector<std::thread> threads;
-    std::atomic<int>* colors = new std::atomic<int>[g.getNumberVertices()];
+    // Colors in one or two bytes and visited in one bit: 5 bytes per vertex
+    // with the parents instead of three ints. Claiming with a CAS on the
+    // color makes visited unnecessary.
+    colorArray colors(g.getNumberVertices(), params.numThreads);
     std::atomic<int>* parents = new std::atomic<int>[g.getNumberVertices()];
-    std::atomic<int>* visited = new std::atomic<int>[g.getNumberVertices()];
-    for (int i = 0; i < g.getNumberVertices(); i++) {
-        colors[i] = 0; parents[i] = BOTTOM; visited[i] = 0;
-    }
+    atomicBitmap visited(params.claimOnce ? 0 : g.getNumberVertices());
+    atomicBitmap expanded(g.getNumberVertices());
+    report.stateBytes = colors.bytes() + visited.bytes() + expanded.bytes()
+        + g.getNumberVertices() * sizeof(std::atomic<int>);
+    // Workers for the setup and the analytics, outside the measured time.
+    ws::Scheduler aux(params.algType, params.numThreads, 64, 4096);
+    ws::parallelFor(aux, 0, g.getNumberVertices(), [&](int i) {
+        colors.store(i, 0, relaxed); parents[i].store(BOTTOM, relaxed);
+    });
+    ws::parallelFor(aux, 0, visited.numWords(), [&](int i) { visited.clearWord(i); });
+    ws::parallelFor(aux, 0, expanded.numWords(), [&](int i) { expanded.clearWord(i); });
+    // Not part of the traversal state: a copy of the graph in another layout
+    std::unique_ptr<adjacencyArray> adjacency;
+    if (params.contiguousAdjacency) adjacency = std::make_unique<adjacencyArray>(g);
 
     workStealingAlgorithm* algs[params.numThreads];
     int* processors = new int[params.numThreads];
     std::atomic<int> counter = 0;
+    // Every worker starts with its root; lets the traversal end when the
+    // roots cannot reach every vertex (forests, directed graphs).
+    std::atomic<int> active = params.numThreads;
     auto wait_for_begin = []() noexcept {};
     std::cout << getAlgorithmTypeFromEnum(params.algType) << std::endl;
     auto t_start = std::chrono::high_resolution_clock::now();
@@ -33,6 +53,9 @@ graph spanningTree(graph& g, int* roots, Report& report, ws::Params& params)
                                                                 params.numThreads);
         algs[i] = c;
     }
+    if (params.hwCounters) {
+        report.counters_.assign(params.numThreads, std::vector<long long>());
+    }
     std::barrier sync_point(params.numThreads, wait_for_begin);
     for (int i = 0; i < params.numThreads; i++) {
         std::function<void(int)> func = [&](int processID) {
@@ -40,9 +63,36 @@ graph spanningTree(graph& g, int* roots, Report& report, ws::Params& params)
             CounterStepSpanningTree step(roots[processID], (processID + 1), false,
                                          g, colors, parents, alg, algs, report,
                                          params.numThreads, params.specialExecution,
-                                         counter, visited);
+                                         counter, visited, expanded, active,
+                                         params.zeroCost, params.claimOnce,
+                                         params.counterBatch);
+            if (report.tracer_) step.trace_ = report.tracer_->worker(processID);
+            step.adjacency_ = adjacency.get();
+            step.prefetchDistance_ = std::max(0, params.prefetchDistance);
+            step.handsOutOnce_ = handsOutOnce(params.algType);
+            if (adjacency) {
+                step.taskBatch_ = std::clamp(params.taskBatch, 1, CounterStepSpanningTree::maxTaskBatch);
+                step.filterNeighbours_ = params.simdFilter;
+                step.simdKernel_ = bestSimdKernel();
+            }
+            std::unique_ptr<perfCounters> counters;
+            if (params.hwCounters) counters = std::make_unique<perfCounters>();
             sync_point.arrive_and_wait();
+            if (counters) counters->start();
             step.graph_traversal_step();
+            if (counters) {
+                counters->stop();
+                std::vector<long long>& values = report.counters_[processID];
+                for (int e = 0; e < PerfEvent::NUM_PERF_EVENTS; e++) {
+                    values.emplace_back(counters->get(static_cast<PerfEvent>(e)));
+                }
+                for (int e = 0; e < PerfEvent::NUM_PERF_EVENTS; e++) {
+                    values.emplace_back(counters->enabledTime(static_cast<PerfEvent>(e)));
+                }
+                for (int e = 0; e < PerfEvent::NUM_PERF_EVENTS; e++) {
+                    values.emplace_back(counters->runningTime(static_cast<PerfEvent>(e)));
+                }
+            }
         };
         threads.emplace_back(std::thread(func, i));
         cpu_set_t cpuset;
@@ -63,11 +113,12 @@ graph spanningTree(graph& g, int* roots, Report& report, ws::Params& params)
     auto t_end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration<long, std::nano>(t_end-t_start).count();
     report.executionTime = duration;
-    for (int i = 0; i < g.getNumberVertices(); i++) {
-        if (colors[i].load() != 0) {
-            processors[colors[i].load() - 1]++; // because we labeled processors from 1..n
-        }
-    }
+    std::unique_ptr<std::atomic<int>[]> counts(new std::atomic<int>[params.numThreads]());
+    ws::parallelFor(aux, 0, g.getNumberVertices(), [&](int i) {
+        int color = colors.load(i, relaxed);
+        if (color != 0) counts[color - 1].fetch_add(1, relaxed); // because we labeled processors from 1..n
+    });
+    for (int i = 0; i < params.numThreads; i++) processors[i] = counts[i].load();
     report.processors_ = processors;
     parents[roots[0]] = BOTTOM; // ensures that first node is always the root of the tree
     for (int i = 1; i < params.numThreads; i++) {
@@ -75,9 +126,7 @@ graph spanningTree(graph& g, int* roots, Report& report, ws::Params& params)
     }
     std::cout << string_format("Se procesaron: %d vertices", counter.load()) << std::endl;
     graph newGraph = buildFromParents(parents, g.getNumberVertices(), roots[0], g.isDirected());
-    delete[] colors;
     delete[] parents;
-    delete[] visited;
     for (int i = 0; i < params.numThreads; i++) {
         delete algs[i];
     }
@@ -85,6 +134,50 @@ graph spanningTree(graph& g, int* roots, Report& report, ws::Params& params)
     return newGraph;
 }
 
+graph sequentialSpanningTree(graph& g, int root, Report& report)
+{
+    const int numVertices = g.getNumberVertices();
+    std::unique_ptr<int[]> colors = std::make_unique<int[]>(numVertices);
+    std::unique_ptr<int[]> parents = std::make_unique<int[]>(numVertices);
+    std::fill(parents.get(), parents.get() + numVertices, BOTTOM);
+    report.stateBytes = 2 * numVertices * sizeof(int);
+    std::vector<int> stack;
+    stack.reserve(numVertices);
+    int puts = 0, takes = 0, expansions = 0, visited = 0;
+    std::cout << getAlgorithmTypeFromEnum(AlgorithmType::SIMPLE) << std::endl;
+    auto t_start = std::chrono::high_resolution_clock::now();
+    colors[root] = 1;
+    stack.emplace_back(root);
+    puts++;
+    visited++;
+    while (!stack.empty()) {
+        int v = stack.back();
+        stack.pop_back();
+        takes++;
+        expansions++;
+        for (int w : g.getNeighbours(v)) {
+            if (colors[w] == 0) {
+                colors[w] = 1;
+                parents[w] = v;
+                stack.emplace_back(w);
+                puts++;
+                visited++;
+            }
+        }
+    }
+    auto t_end = std::chrono::high_resolution_clock::now();
+    report.executionTime = std::chrono::duration<long, std::nano>(t_end - t_start).count();
+    report.puts = puts;
+    report.takes = takes;
+    report.expansions = expansions;
+    int* processors = new int[report.numProcessors_]();
+    processors[0] = visited;
+    report.processors_ = processors;
+    parents[root] = BOTTOM;
+    std::cout << string_format("Se procesaron: %d vertices", visited) << std::endl;
+    return buildFromParents(parents.get(), numVertices, root, g.isDirected());
+}
+
 void CounterStepSpanningTree::graph_traversal_step()
 {
     if (specialExecution_) {
@@ -94,45 +187,181 @@ void CounterStepSpanningTree::graph_traversal_step()
     }
 }
 
-void CounterStepSpanningTree::generalExecution()
+bool CounterStepSpanningTree::claim(int w, int v)
+{
+    if (claimOnce_) {
+        // One CAS on the color: exactly one worker gets each vertex
+        if (colors_.load(w, relaxed) != 0 || !colors_.claim(w, label_)) return false;
+        parents_[w].store(v);
+        if (++localCount_ == counterBatch_) flushCount();
+        return true;
+    }
+    // Check-then-store: several workers may get, put and expand w
+    if (colors_.load(w) != 0) return false;
+    colors_.store(w, label_);
+    parents_[w].store(v);
+    if (visited_.testAndSet(w) && ++localCount_ == counterBatch_) flushCount();
+    return true;
+}
+
+void CounterStepSpanningTree::flushCount()
+{
+    if (localCount_ == 0) return;
+    counter_ += localCount_;
+    localCount_ = 0;
+}
+
+bool CounterStepSpanningTree::firstExpansion(int v)
 {
-    colors_[root_].store(label_);
-    algorithm_->put(root_);
-    if (visited_[root_].exchange(1) == 0) {
-        counter_++;
+    if (expanded_.testAndSet(v)) return true;
+    report_.incDuplicates();
+    return false;
+}
+
+bool CounterStepSpanningTree::shouldExpand(int v)
+{
+    // Each claimed vertex is put once, and these deques take it once
+    if (claimOnce_ && handsOutOnce_) return true;
+    // Without claimOnce_ duplicates are still expanded, as before
+    return firstExpansion(v) || !claimOnce_;
+}
+
+void CounterStepSpanningTree::putVertex(int w)
+{
+    if (specialExecution_) {
+        algorithm_->put(w, label_ - 1);
+    } else {
+        algorithm_->put(w);
     }
     report_.incPuts();
-    int v, w, stolenItem, thread;
-    do {
-        while (!algorithm_->isEmpty()) {
-            v = algorithm_->take();
-            report_.incTakes();
-            if (v >= 0) {
-                std::list<int>& neighbors = g_.getNeighbours(v);
-                for(auto it = neighbors.begin(); it != neighbors.end(); it++) {
-                    w = *it;
-                    if (colors_[w].load() == 0) {
-                        colors_[w].store(label_);
-                        parents_[w].store(v);
-                        algorithm_->put(w);
-                        if (visited_[w].exchange(1) == 0) {
-                            counter_++;
-                        }
-                        report_.incPuts();
+    WS_TRACE(trace_, TRACE_PUT, w);
+}
+
+void CounterStepSpanningTree::prefetchColors(const int* first, const int* last) const
+{
+    for (int k = 0; k < prefetchDistance_ && first != last; k++, first++) colors_.prefetch(*first);
+}
+
+void CounterStepSpanningTree::expand(const int* batch, int n)
+{
+    if (adjacency_ == nullptr) {
+        for (int i = 0; i < n; i++) expandList(batch[i]);
+        return;
+    }
+    // The neighbour arrays of the whole batch are requested first, and the
+    // colors of the next vertex's neighbours while the current one is
+    // expanded, so the misses of the batch overlap instead of queueing.
+    for (int i = 0; i < n; i++) WS_PREFETCH(adjacency_->begin(batch[i]), 0);
+    if (n > 0) prefetchColors(adjacency_->begin(batch[0]), adjacency_->end(batch[0]));
+    int last = -1;
+    for (int i = 0; i < n; i++) {
+        int v = batch[i];
+        const int* end = adjacency_->end(v);
+        if (i + 1 < n) prefetchColors(adjacency_->begin(batch[i + 1]), adjacency_->end(batch[i + 1]));
+        report_.incExpansions();
+        if (filterNeighbours_) {
+            int unvisited[filterChunk];
+            for (const int* it = adjacency_->begin(v); it < end; it += filterChunk) {
+                int count = unvisitedNeighbours(colors_, it, std::min<long>(filterChunk, end - it),
+                                                unvisited, simdKernel_);
+                for (int j = 0; j < count; j++) {
+                    if (claim(unvisited[j], v)) {
+                        putVertex(unvisited[j]);
+                        last = unvisited[j];
                     }
                 }
             }
+            continue;
         }
-        if (numThreads_ > 1) {
+        for (const int* it = adjacency_->begin(v); it != end; it++) {
+            if (prefetchDistance_ > 0 && end - it > prefetchDistance_) colors_.prefetch(it[prefetchDistance_]);
+            if (claim(*it, v)) {
+                putVertex(*it);
+                last = *it;
+            }
+        }
+    }
+    // The owner takes the last vertex put next (LIFO)
+    if (last >= 0 && prefetchDistance_ > 0) adjacency_->prefetch(last);
+}
+
+void CounterStepSpanningTree::expandList(int v)
+{
+    report_.incExpansions();
+    std::list<int>& neighbors = g_.getNeighbours(v);
+    // ahead runs prefetchDistance_ nodes in front of it
+    auto ahead = neighbors.begin();
+    for (int k = 0; k < prefetchDistance_ && ahead != neighbors.end(); k++, ahead++) colors_.prefetch(*ahead);
+    int last = -1;
+    for (auto it = neighbors.begin(); it != neighbors.end(); it++) {
+        if (ahead != neighbors.end()) {
+            colors_.prefetch(*ahead);
+            ahead++;
+        }
+        int w = *it;
+        if (claim(w, v)) {
+            putVertex(w);
+            last = w;
+        }
+    }
+    // The owner takes the last vertex put next (LIFO): its list header
+    if (last >= 0 && prefetchDistance_ > 0) WS_PREFETCH(&g_.getNeighbours(last), 0);
+}
+
+void CounterStepSpanningTree::generalExecution()
+{
+    // Another worker may have reached the root first
+    if (claim(root_, BOTTOM) || !claimOnce_) {
+        algorithm_->put(root_);
+        report_.incPuts();
+        WS_TRACE(trace_, TRACE_PUT, root_);
+    }
+    int v, stolenItem, thread;
+    bool idle = false;
+    do {
+        while (!algorithm_->isEmpty()) {
+            int batch[maxTaskBatch];
+            int n = 0;
+            do {
+                v = algorithm_->take();
+                report_.incTakes();
+                if (v >= 0) {
+                    WS_TRACE(trace_, TRACE_TAKE, v);
+                    if (shouldExpand(v)) batch[n++] = v;
+                }
+            } while (n < taskBatch_ && !algorithm_->isEmpty());
+            expand(batch, n);
+        }
+        if (!idle) {
+            idle = true;
+            flushCount();
+            active_--;
+            WS_TRACE(trace_, TRACE_IDLE_BEGIN, 0);
+        }
+        // Quiescence: only active workers put, and their deques are the
+        // only ones with vertices, so nothing is left once none is active.
+        if (active_.load() == 0) break;
+        if (numThreads_ > 1 && !zeroCost_) {
             thread = pickRandomThread(numThreads_, label_ - 1);
+            WS_TRACE(trace_, TRACE_STEAL_ATTEMPT, thread);
+            // Active before the steal, so a stolen vertex is always counted
+            active_++;
             stolenItem = algorithms_[thread]->steal();
             report_.incSteals();
             if (stolenItem >= 0) {
+                WS_TRACE(trace_, TRACE_STEAL_SUCCESS, stolenItem);
+                idle = false;
+                WS_TRACE(trace_, TRACE_IDLE_END, 0);
                 algorithm_->put(stolenItem);
                 report_.incPuts();
+                WS_TRACE(trace_, TRACE_PUT, stolenItem);
+            } else {
+                active_--;
             }
         }
-    } while(counter_.load() < g_.getNumberVertices());
+    } while(!allVisited());
+    flushCount();
+    if (idle) WS_TRACE(trace_, TRACE_IDLE_END, 0);
 }
 
 
@@ -141,43 +370,58 @@ void CounterStepSpanningTree::specialExecution()
     // label_ is ProcessID + 1, so, to use the work-stealing
     // algorithms with label, is necessary call the methods with
     // label_ - 1
-    colors_[root_].store(label_);
-    algorithm_->put(root_, label_ - 1);
-    if (visited_[root_].exchange(1) == 0) {
-        counter_++;
+    // Another worker may have reached the root first
+    if (claim(root_, BOTTOM) || !claimOnce_) {
+        algorithm_->put(root_, label_ - 1);
+        report_.incPuts();
+        WS_TRACE(trace_, TRACE_PUT, root_);
     }
-    report_.incPuts();
-    int v, w, stolenItem, thread;
+    int v, stolenItem, thread;
+    bool idle = false;
     do {
         while (!algorithm_->isEmpty(label_ - 1)) {
-            v = algorithm_->take(label_ - 1);
-            report_.incTakes();
-            if (v >= 0) {
-                std::list<int>& neighbors = g_.getNeighbours(v);
-                for(auto it = neighbors.begin(); it != neighbors.end(); it++) {
-                    w = *it;
-                    if (colors_[w].load() == 0) {
-                        colors_[w].store(label_);
-                        parents_[w].store(v);
-                        algorithm_->put(w, label_ - 1);
-                        if (visited_[w].exchange(1) == 0) {
-                            counter_++;
-                        }
-                        report_.incPuts();
-                    }
+            int batch[maxTaskBatch];
+            int n = 0;
+            do {
+                v = algorithm_->take(label_ - 1);
+                report_.incTakes();
+                if (v >= 0) {
+                    WS_TRACE(trace_, TRACE_TAKE, v);
+                    if (shouldExpand(v)) batch[n++] = v;
                 }
-            }
+            } while (n < taskBatch_ && !algorithm_->isEmpty(label_ - 1));
+            expand(batch, n);
         }
-        if (numThreads_ > 1) {
+        if (!idle) {
+            idle = true;
+            flushCount();
+            active_--;
+            WS_TRACE(trace_, TRACE_IDLE_BEGIN, 0);
+        }
+        // Quiescence: only active workers put, and their deques are the
+        // only ones with vertices, so nothing is left once none is active.
+        if (active_.load() == 0) break;
+        if (numThreads_ > 1 && !zeroCost_) {
             thread = pickRandomThread(numThreads_, label_ - 1);
+            WS_TRACE(trace_, TRACE_STEAL_ATTEMPT, thread);
+            // Active before the steal, so a stolen vertex is always counted
+            active_++;
             stolenItem = algorithms_[thread]->steal(label_ - 1);
             report_.incSteals();
             if (stolenItem >= 0) {
+                WS_TRACE(trace_, TRACE_STEAL_SUCCESS, stolenItem);
+                idle = false;
+                WS_TRACE(trace_, TRACE_IDLE_END, 0);
                 algorithm_->put(stolenItem, label_ - 1);
                 report_.incPuts();
+                WS_TRACE(trace_, TRACE_PUT, stolenItem);
+            } else {
+                active_--;
             }
         }
-    } while(counter_.load() < g_.getNumberVertices());
+    } while(!allVisited());
+    flushCount();
+    if (idle) WS_TRACE(trace_, TRACE_IDLE_END, 0);
 }
 
 GraphType getGraphTypeFromString(std::string type) {
@@ -196,6 +440,70 @@ std::string getGraphTypeFromEnum(GraphType type) {
     return "RANDOM";
 }
 
+std::string getReorderTypeFromEnum(ReorderType type)
+{
+    switch (type) {
+    case ReorderType::NO_REORDER:
+        return "NO_REORDER";
+    case ReorderType::BFS_ORDER:
+        return "BFS_ORDER";
+    case ReorderType::RCM:
+        return "RCM";
+    case ReorderType::HILBERT:
+        return "HILBERT";
+    }
+    return "UNKNOWN";
+}
+
+ReorderType getReorderTypeFromString(std::string type)
+{
+    for (int r = ReorderType::NO_REORDER; r <= ReorderType::HILBERT; r++) {
+        ReorderType reorder = static_cast<ReorderType>(r);
+        if (type == getReorderTypeFromEnum(reorder)) return reorder;
+    }
+    throw std::invalid_argument("Unknown reordering: " + type);
+}
+
+std::string getWorkloadTypeFromEnum(WorkloadType type)
+{
+    switch (type) {
+    case WorkloadType::SPANNING_TREE:
+        return "SPANNING_TREE";
+    case WorkloadType::BFS_WS:
+        return "BFS_WS";
+    case WorkloadType::BFS_TOP_DOWN:
+        return "BFS_TOP_DOWN";
+    case WorkloadType::BFS_DIRECTION_OPT:
+        return "BFS_DIRECTION_OPT";
+    case WorkloadType::CONNECTED_COMPONENTS:
+        return "CONNECTED_COMPONENTS";
+    case WorkloadType::UTS:
+        return "UTS";
+    }
+    return "UNKNOWN";
+}
+
+WorkloadType getWorkloadTypeFromString(std::string type)
+{
+    for (int w = WorkloadType::SPANNING_TREE; w <= WorkloadType::UTS; w++) {
+        WorkloadType workload = static_cast<WorkloadType>(w);
+        if (type == getWorkloadTypeFromEnum(workload)) return workload;
+    }
+    throw std::invalid_argument("Unknown workload: " + type);
+}
+
+std::string getUtsTreeTypeFromEnum(UtsTreeType type)
+{
+    return type == UtsTreeType::BINOMIAL ? "BINOMIAL" : "GEOMETRIC";
+}
+
+UtsTreeType getUtsTreeTypeFromString(std::string type)
+{
+    if (type == "BINOMIAL") return UtsTreeType::BINOMIAL;
+    if (type == "GEOMETRIC") return UtsTreeType::GEOMETRIC;
+    throw std::invalid_argument("Unknown UTS tree: " + type);
+}
+
 std::string getAlgorithmTypeFromEnum(AlgorithmType type)
 {
     switch(type) {
@@ -203,6 +511,20 @@ std::string getAlgorithmTypeFromEnum(AlgorithmType type)
         return "CHASELEV";
     case AlgorithmType::CILK:
         return "CILK";
+    case AlgorithmType::CILK_TTAS:
+        return "CILK_TTAS";
+    case AlgorithmType::CILK_TICKET:
+        return "CILK_TICKET";
+    case AlgorithmType::CILK_MCS:
+        return "CILK_MCS";
+    case AlgorithmType::CHASELEV_FENCE_FREE:
+        return "CHASELEV_FENCE_FREE";
+    case AlgorithmType::CILK_FENCE_FREE:
+        return "CILK_FENCE_FREE";
+    case AlgorithmType::CHASELEV_MEMBARRIER:
+        return "CHASELEV_MEMBARRIER";
+    case AlgorithmType::CILK_MEMBARRIER:
+        return "CILK_MEMBARRIER";
     // case AlgorithmType::IDEMPOTENT_DEQUE:
     //     return "IDEMPOTENT_DEQUE";
     // case AlgorithmType::IDEMPOTENT_DEQUE_2:
@@ -215,16 +537,32 @@ std::string getAlgorithmTypeFromEnum(AlgorithmType type)
         return "WS_NC_MULT";
     case AlgorithmType::B_WS_NC_MULT_OPT:
         return "B_WS_NC_MULT";
-    // case AlgorithmType::B_WS_NC_MULT_LA_OPT:
+    case AlgorithmType::B_WS_NC_MULT_LA_OPT:
+        return "B_WS_NC_MULT_LA_OPT";
+    case AlgorithmType::WS_NC_MULT_RING_OPT:
+        return "WS_NC_MULT_RING_OPT";
     case AlgorithmType::WS_NC_MULT_LA_OPT:
         return "WS_NC_MULT_LA_OPT";
-    // case AlgorithmType::SIMPLE:
+    case AlgorithmType::SIMPLE:
+        return "SIMPLE";
     default:
         return "UNKNOWN";
     }
     return "UNKNOWN";
 }
 
+AlgorithmType getAlgorithmTypeFromString(std::string type)
+{
+    if (type == "SIMPLE") return AlgorithmType::SIMPLE;
+    for (int at = AlgorithmType::CHASELEV; at != AlgorithmType::LAST; at++) {
+        AlgorithmType atype = static_cast<AlgorithmType>(at);
+        if (type == getAlgorithmTypeFromEnum(atype)) return atype;
+    }
+    if (type == "WS_NC_MULT_OPT") return AlgorithmType::WS_NC_MULT_OPT;
+    if (type == "B_WS_NC_MULT_OPT") return AlgorithmType::B_WS_NC_MULT_OPT;
+    throw std::invalid_argument("Unknown algorithm type: " + type);
+}
+
 void print(std::list<int> const &list)
 {
     std::copy(list.begin(),
@@ -232,22 +570,67 @@ void print(std::list<int> const &list)
               std::ostream_iterator<int>(std::cout, "\n\n"));
 }
 
-json experiment(ws::Params &params, graph& g)
+json experiment(ws::Params &params, graph& g, tracer* trace)
 {
     int* processors = new int[params.numThreads];
     Report r{params.numThreads, processors};
-    int* roots = stubSpanning(g, params.numThreads);
-    graph tree = spanningTree(g, roots, r, params);
-    assert(isTree(tree));
+    r.tracer_ = trace;
     json result;
+    int* roots = nullptr;
+    if (params.workload == WorkloadType::SPANNING_TREE) {
+        roots = stubSpanning(g, params.numThreads);
+        graph tree = spanningTree(g, roots, r, params);
+        int reached = 0;
+        for (int i = 0; i < r.numProcessors_; i++) reached += r.processors_[i];
+        // Vertices the roots cannot reach stay out of the tree
+        assert(reached == g.getNumberVertices() ? isTree(tree)
+               : detectCycleType(tree) == GraphCycleType::DISCONNECTED);
+        result["reached"] = reached;
+        result["stateBytes"] = r.stateBytes;
+        if (params.contiguousAdjacency && params.simdFilter) {
+            result["simdKernel"] = getSimdKernelName(bestSimdKernel());
+        }
+    } else if (params.workload == WorkloadType::UTS) {
+        utsResult u = uts(r, params);
+        result["nodes"] = u.nodes;
+        result["leaves"] = u.leaves;
+        result["maxDepth"] = u.maxDepth;
+        result["utsTree"] = getUtsTreeTypeFromEnum(params.utsTree);
+        result["nodesPerSecond"] = r.executionTime > 0 ? u.nodes * 1e9 / r.executionTime : 0.0;
+    } else if (params.workload == WorkloadType::CONNECTED_COMPONENTS) {
+        componentsResult c = components(g, r, params);
+        assert(validateComponents(g, c));
+        result["edges"] = c.edges;
+        result["components"] = c.numComponents;
+        result["largestComponent"] = c.sizes.empty() ? 0 : c.sizes.front();
+        result["singletons"] = std::count(c.sizes.begin(), c.sizes.end(), 1);
+        result["merges"] = c.merges;
+        result["gteps"] = r.executionTime > 0 ? static_cast<double>(c.edges) / r.executionTime : 0.0;
+    } else {
+        bfsResult b = bfs(g, g.getRoot(), r, params);
+        assert(validateBfs(g, g.getRoot(), b));
+        result["edges"] = b.edges;
+        result["levels"] = b.levels;
+        result["bottomUpLevels"] = b.bottomUpLevels;
+        result["parentsTime"] = b.parentsTime;
+        // Edges per nanosecond is 10^9 edges per second
+        result["gteps"] = r.executionTime > 0 ? static_cast<double>(b.edges) / r.executionTime : 0.0;
+    }
     result["numThreads"] = params.numThreads;
     result["executionTime"] = r.executionTime;
     result["takes"] = r.takes.load();
     result["puts"] = r.puts.load();
     result["steals"] = r.steals.load();
+    result["expansions"] = r.expansions.load();
+    result["duplicates"] = r.duplicates.load();
+    result["zeroCost"] = params.zeroCost;
     result["graphType"] = getGraphTypeFromEnum(params.graphType);
     result["algorithm"] = getAlgorithmTypeFromEnum(params.algType);
+    result["workload"] = getWorkloadTypeFromEnum(params.workload);
+    if (!r.counters_.empty()) result["perf"] = perfToJson(r.counters_);
+    if (trace != nullptr && params.algType != AlgorithmType::SIMPLE) result["trace"] = trace->summary();
     json par = params;
+    result["params"] = par;
     delete[] processors;
     delete[] roots;
     return result;
@@ -275,19 +658,138 @@ bool isSpecial(AlgorithmType type)
     case AlgorithmType::WS_NC_MULT_OPT:
     case AlgorithmType::B_WS_NC_MULT_OPT:
     case AlgorithmType::WS_NC_MULT_LA_OPT:
+    case AlgorithmType::B_WS_NC_MULT_LA_OPT:
+    case AlgorithmType::WS_NC_MULT_RING_OPT:
         return true;
     default:
         return false;
     }
 }
 
-json experimentComplete(GraphType type, int shape, bool directed)
+bool handsOutOnce(AlgorithmType type)
 {
-    const int numProcessors = std::thread::hardware_concurrency();
+    switch(type) {
+    case AlgorithmType::IDEMPOTENT_FIFO:
+    case AlgorithmType::IDEMPOTENT_LIFO:
+        return false;
+    default:
+        return !isSpecial(type);
+    }
+}
+
+json experimentStatistics(ws::Params &params, graph &g)
+{
+    for (int i = 0; i < params.numWarmUps; i++) {
+        experiment(params, g);
+    }
+    std::vector<std::string> metrics = {"executionTime", "takes", "puts", "steals", "expansions", "duplicates"};
+    if (params.workload == WorkloadType::UTS) {
+        metrics.emplace_back("nodesPerSecond");
+    } else if (params.workload != WorkloadType::SPANNING_TREE) {
+        metrics.emplace_back("gteps");
+    }
+    std::unordered_map<std::string, std::vector<double>> samples;
+    int repetitions = std::max(1, params.numIterExps);
+    std::unordered_map<std::string, std::vector<double>> perf, scaling;
     json last;
-    std::unordered_map<AlgorithmType, std::vector<json>> data = buildLists();
-    std::vector<json> values;
+    for (int i = 0; i < repetitions; i++) {
+        json r = experiment(params, g);
+        for (auto& m : metrics) samples[m].emplace_back(r[m].get<double>());
+        last = r;
+        if (!r.contains("perf")) continue;
+        for (int e = 0; e < PerfEvent::NUM_PERF_EVENTS; e++) {
+            std::string name = getPerfEventName(static_cast<PerfEvent>(e));
+            if (!r["perf"][name].is_null()) perf[name].emplace_back(r["perf"][name].get<double>());
+            if (!r["perf"]["scaling"][name].is_null()) {
+                scaling[name].emplace_back(r["perf"]["scaling"][name].get<double>());
+            }
+        }
+    }
+    json result;
+    result["numThreads"] = params.numThreads;
+    result["graphType"] = getGraphTypeFromEnum(params.graphType);
+    result["algorithm"] = getAlgorithmTypeFromEnum(params.algType);
+    result["workload"] = getWorkloadTypeFromEnum(params.workload);
+    result["warmUps"] = params.numWarmUps;
+    result["zeroCost"] = params.zeroCost;
+    result["repetitions"] = repetitions;
+    for (auto& m : metrics) result[m] = summarize(samples[m]);
+    // Neither the graph nor the UTS tree change between repetitions
+    if (params.workload == WorkloadType::CONNECTED_COMPONENTS) {
+        for (auto key : {"edges", "components", "largestComponent", "singletons"}) result[key] = last[key];
+    }
+    if (params.workload == WorkloadType::UTS) {
+        for (auto key : {"nodes", "leaves", "maxDepth", "utsTree"}) result[key] = last[key];
+    }
+    if (params.hwCounters) {
+        json counters;
+        json counterScaling;
+        for (int e = 0; e < PerfEvent::NUM_PERF_EVENTS; e++) {
+            std::string name = getPerfEventName(static_cast<PerfEvent>(e));
+            counters[name] = perf.count(name) ? summarize(perf[name]) : json(nullptr);
+            counterScaling[name] = scaling.count(name) ? summarize(scaling[name]) : json(nullptr);
+        }
+        counters["available"] = !perf.empty();
+        counters["scaling"] = counterScaling;
+        result["perf"] = counters;
+    }
+    result["params"] = params;
+    return result;
+}
+
+json baselineStatistics(ws::Params params, graph &g)
+{
+    params.algType = AlgorithmType::SIMPLE;
+    params.numThreads = 1;
+    params.specialExecution = false;
+    params.zeroCost = false;
+    return experimentStatistics(params, g);
+}
+
+static double medianOf(const json& metric)
+{
+    return metric.is_object() ? metric["median"].get<double>() : metric.get<double>();
+}
+
+void addBaselineMetrics(json& result, const json& baseline)
+{
+    double baseTime = medianOf(baseline["executionTime"]);
+    double baseExpansions = medianOf(baseline["expansions"]);
+    double time = medianOf(result["executionTime"]);
+    double expansions = medianOf(result["expansions"]);
+    int numThreads = result["numThreads"].get<int>();
+    if (result.value("zeroCost", false)) {
+        // Cost of the put/take operations over the plain stack
+        result["overhead"] = baseTime > 0 ? time / baseTime : 0.0;
+        return;
+    }
+    double speedup = time > 0 ? baseTime / time : 0.0;
+    result["speedup"] = speedup;
+    result["efficiency"] = speedup / numThreads;
+    // Vertices expanded by all workers over the vertices expanded by the
+    // sequential traversal, i.e., work repeated because of multiplicity
+    // or races on colors.
+    result["workInflation"] = baseExpansions > 0 ? expansions / baseExpansions : 0.0;
+}
+
+void experimentComplete(GraphType type, int shape, bool directed, std::ostream& out)
+{
+    const int numProcessors = std::thread::hardware_concurrency();
     graph g = graphFactory(type, shape, directed);
+    ws::Params base{type, shape, false, 1, AlgorithmType::SIMPLE, 8192, 10,
+        StepSpanningTreeType::COUNTER, false, false, false, false, 1};
+    json baseline = baselineStatistics(base, g);
+    out << baseline.dump() << std::endl;
+    // Zero-cost experiments: one worker, no steals, only puts and takes
+    for (int at = AlgorithmType::CHASELEV; at != AlgorithmType::LAST; at++) {
+        AlgorithmType atype = static_cast<AlgorithmType>(at);
+        ws::Params p{type, shape, false, 1, atype, 8192, 10,
+            StepSpanningTreeType::COUNTER, false, false, false,
+            isSpecial(atype), 1, true};
+        json result = experimentStatistics(p, g);
+        addBaselineMetrics(result, baseline);
+        out << result.dump() << std::endl;
+    }
     for (int i = 0; i < numProcessors; i++) {
         std::cout << string_format("Iteración: %d\n", i);
         // int structSize = calculateStructSize(type, shape);
@@ -296,14 +798,12 @@ json experimentComplete(GraphType type, int shape, bool directed)
             bool special = isSpecial(atype);
             ws::Params p{type, shape, false,
                 (i + 1), atype, 8192, 10, StepSpanningTreeType::COUNTER,
-                false, false, false, special};
-            json result = experiment(p, g);
-            data[atype].emplace_back(result);
-            values.emplace_back(result);
+                false, false, false, special, 1};
+            json result = experimentStatistics(p, g);
+            addBaselineMetrics(result, baseline);
+            out << result.dump() << std::endl;
         }
     }
-    last["values"] = values;
-    return last;
 }
 
 json compare(json properties) {
@@ -0,0 +1,62 @@
+#include "ws/lib.hpp"
+#include <cstdio>
+#include <cstdlib>
+#if defined(__linux__) && __has_include(<linux/membarrier.h>)
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define WS_MEMBARRIER
+#endif
+
+////////////////
+// Membarrier //
+////////////////
+
+// MEMBARRIER_CMD_PRIVATE_EXPEDITED interrupts the cores running threads of
+// the process and makes each of them execute a full fence before the call
+// returns, which is the fence the owner of a MEMBARRIER deque skips. The
+// process has to register before its first use.
+
+namespace {
+
+#ifdef WS_MEMBARRIER
+long membarrier(int cmd)
+{
+    return syscall(__NR_membarrier, cmd, 0);
+}
+#endif
+
+bool registerMembarrier()
+{
+#ifdef WS_MEMBARRIER
+    long supported = membarrier(MEMBARRIER_CMD_QUERY);
+    if (supported < 0 || !(supported & MEMBARRIER_CMD_PRIVATE_EXPEDITED)) return false;
+    return membarrier(MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED) == 0;
+#else
+    return false;
+#endif
+}
+
+}
+
+bool membarrierAvailable()
+{
+    static const bool available = registerMembarrier();
+    return available;
+}
+
+void processWideFence()
+{
+#ifdef WS_MEMBARRIER
+    if (membarrierAvailable()) {
+        // Owners are already skipping their fence, so a local one would not
+        // order anything: a task could come out twice.
+        if (membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED) != 0) {
+            std::perror("membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED)");
+            std::abort();
+        }
+        return;
+    }
+#endif
+    std::atomic_thread_fence(seq_cst);
+}
@@ -1,4 +1,5 @@
 #include "ws/lib.hpp"
+#include <algorithm>
 
 void ws::to_json(json& j, const Params& p)
 {
@@ -6,14 +7,30 @@ void ws::to_json(json& j, const Params& p)
              {"shape", p.shape},
              {"report", p.report},
              {"numThreads", p.numThreads},
-             {"algType", p.algType},
+             {"algType", getAlgorithmTypeFromEnum(p.algType)},
              {"structSize", p.structSize},
              {"numIterExps", p.numIterExps},
              {"stepSpanningType", p.stepSpanningType},
              {"directed", p.directed},
              {"stealTime", p.stealTime},
              {"allTime", p.allTime},
-             {"specialExecution", p.specialExecution}
+             {"specialExecution", p.specialExecution},
+             {"numWarmUps", p.numWarmUps},
+             {"zeroCost", p.zeroCost},
+             {"hwCounters", p.hwCounters},
+             {"claimOnce", p.claimOnce},
+             {"counterBatch", p.counterBatch},
+             {"prefetchDistance", p.prefetchDistance},
+             {"contiguousAdjacency", p.contiguousAdjacency},
+             {"taskBatch", p.taskBatch},
+             {"reorder", p.reorder},
+             {"workload", p.workload},
+             {"utsTree", p.utsTree},
+             {"utsBranching", p.utsBranching},
+             {"utsDepth", p.utsDepth},
+             {"utsQ", p.utsQ},
+             {"utsM", p.utsM},
+             {"utsSeed", p.utsSeed}
     };
 };
 
@@ -23,7 +40,13 @@ void ws::from_json(const json& j, Params& p)
     j.at("shape").get_to(p.shape);
     j.at("report").get_to(p.report);
     j.at("numThreads").get_to(p.numThreads);
-    j.at("algType").get_to(p.algType);
+    // By name; older files have the number
+    const json& algType = j.at("algType");
+    if (algType.is_string()) {
+        p.algType = getAlgorithmTypeFromString(algType.get<std::string>());
+    } else {
+        algType.get_to(p.algType);
+    }
     j.at("structSize").get_to(p.structSize);
     j.at("numIterExps").get_to(p.numIterExps);
     j.at("stepSpanningType").get_to(p.stepSpanningType);
@@ -31,4 +54,100 @@ void ws::from_json(const json& j, Params& p)
     j.at("stealTime").get_to(p.stealTime);
     j.at("allTime").get_to(p.allTime);
     j.at("specialExecution").get_to(p.specialExecution);
+    p.numWarmUps = j.value("numWarmUps", 0);
+    p.zeroCost = j.value("zeroCost", false);
+    p.hwCounters = j.value("hwCounters", false);
+    p.claimOnce = j.value("claimOnce", true);
+    p.counterBatch = j.value("counterBatch", 64);
+    p.prefetchDistance = j.value("prefetchDistance", 8);
+    p.contiguousAdjacency = j.value("contiguousAdjacency", false);
+    p.taskBatch = j.value("taskBatch", 4);
+    p.reorder = j.value("reorder", ReorderType::NO_REORDER);
+    p.workload = j.value("workload", WorkloadType::SPANNING_TREE);
+    p.utsTree = j.value("utsTree", UtsTreeType::GEOMETRIC);
+    p.utsBranching = j.value("utsBranching", 4.0);
+    p.utsDepth = j.value("utsDepth", 10);
+    p.utsQ = j.value("utsQ", 0.124875);
+    p.utsM = j.value("utsM", 8);
+    p.utsSeed = j.value("utsSeed", 19);
 };
+
+ws::Params ws::defaultParams()
+{
+    return ws::Params{GraphType::TORUS_2D, 100, false, 1, AlgorithmType::CHASELEV,
+        8192, 10, StepSpanningTreeType::COUNTER, false, false, false, false, 2};
+}
+
+// Enum fields may be given either by name or by their numeric value.
+static json enumValue(const std::string& key, const json& value)
+{
+    if (!value.is_string()) return value;
+    std::string name = value.get<std::string>();
+    if (key == "graphType") {
+        GraphType type = getGraphTypeFromString(name);
+        if (getGraphTypeFromEnum(type) != name) {
+            throw std::invalid_argument("Unknown graph type: " + name);
+        }
+        return type;
+    }
+    if (key == "algType") return getAlgorithmTypeFromString(name);
+    if (key == "workload") return getWorkloadTypeFromString(name);
+    if (key == "utsTree") return getUtsTreeTypeFromString(name);
+    if (key == "reorder") return getReorderTypeFromString(name);
+    if (key == "stepSpanningType") {
+        if (name == "COUNTER") return StepSpanningTreeType::COUNTER;
+        if (name == "DOUBLE_COLLECT") return StepSpanningTreeType::DOUBLE_COLLECT;
+        throw std::invalid_argument("Unknown step type: " + name);
+    }
+    return value;
+}
+
+std::vector<ws::Params> ws::expandParams(const json& config)
+{
+    // Every field may hold a list of values; the result is the cartesian
+    // product of all of them, ordered as graph (or UTS tree), workload, threads
+    // and algorithm.
+    json base = ws::defaultParams();
+    std::vector<std::string> keys;
+    std::vector<std::vector<json>> values;
+    for (auto& [key, value] : config.items()) {
+        if (!base.contains(key)) throw std::invalid_argument("Unknown parameter: " + key);
+        std::vector<json> options;
+        if (value.is_array()) {
+            for (auto& v : value) options.emplace_back(enumValue(key, v));
+        } else {
+            options.emplace_back(enumValue(key, value));
+        }
+        if (options.empty()) throw std::invalid_argument("Empty list for parameter: " + key);
+        keys.emplace_back(key);
+        values.emplace_back(options);
+    }
+    std::vector<std::string> order = {"graphType", "shape", "directed", "reorder", "utsTree", "utsBranching", "utsDepth",
+                                      "utsQ", "utsM", "utsSeed", "workload", "numThreads", "algType"};
+    std::vector<size_t> idx(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) idx[i] = i;
+    std::stable_sort(idx.begin(), idx.end(), [&](size_t a, size_t b) {
+        auto pa = std::find(order.begin(), order.end(), keys[a]) - order.begin();
+        auto pb = std::find(order.begin(), order.end(), keys[b]) - order.begin();
+        return pa < pb;
+    });
+
+    std::vector<ws::Params> result;
+    std::vector<size_t> pos(keys.size(), 0);
+    while (true) {
+        json current = base;
+        for (size_t i = 0; i < keys.size(); i++) current[keys[i]] = values[i][pos[i]];
+        ws::Params p = current.get<ws::Params>();
+        p.specialExecution = isSpecial(p.algType);
+        result.emplace_back(p);
+        // Advance the odometer, last key in `order` changes fastest
+        int k = static_cast<int>(idx.size()) - 1;
+        for (; k >= 0; k--) {
+            size_t i = idx[k];
+            if (++pos[i] < values[i].size()) break;
+            pos[i] = 0;
+        }
+        if (k < 0) break;
+    }
+    return result;
+}
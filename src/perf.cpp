@@ -0,0 +1,205 @@
+#include "ws/lib.hpp"
+#include <cstdint>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/////////////////////////////////////
+// Hardware performance counters //
+/////////////////////////////////////
+
+std::string getPerfEventName(PerfEvent event)
+{
+    switch (event) {
+    case PerfEvent::CYCLES:
+        return "cycles";
+    case PerfEvent::INSTRUCTIONS:
+        return "instructions";
+    case PerfEvent::L1D_MISSES:
+        return "l1dMisses";
+    case PerfEvent::LLC_MISSES:
+        return "llcMisses";
+    case PerfEvent::BRANCH_MISSES:
+        return "branchMisses";
+    case PerfEvent::CONTEXT_SWITCHES:
+        return "contextSwitches";
+    default:
+        return "unknown";
+    }
+}
+
+#ifdef __linux__
+
+static int openCounter(PerfEvent event)
+{
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.disabled = 1;
+    // User space only, so it works with perf_event_paranoid <= 2
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    switch (event) {
+    case PerfEvent::CYCLES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case PerfEvent::INSTRUCTIONS:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case PerfEvent::L1D_MISSES:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_L1D
+            | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    case PerfEvent::LLC_MISSES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        break;
+    case PerfEvent::BRANCH_MISSES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    case PerfEvent::CONTEXT_SWITCHES:
+        attr.type = PERF_TYPE_SOFTWARE;
+        attr.config = PERF_COUNT_SW_CONTEXT_SWITCHES;
+        attr.exclude_kernel = 0;
+        break;
+    default:
+        return -1;
+    }
+    // pid = 0 and cpu = -1: the calling thread, on any processor
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+perfCounters::perfCounters()
+{
+    for (int e = 0; e < PerfEvent::NUM_PERF_EVENTS; e++) {
+        fds[e] = openCounter(static_cast<PerfEvent>(e));
+        values[e] = fds[e] >= 0 ? 0 : -1;
+        enabled[e] = 0;
+        running[e] = 0;
+    }
+}
+
+perfCounters::~perfCounters()
+{
+    for (int e = 0; e < PerfEvent::NUM_PERF_EVENTS; e++) {
+        if (fds[e] >= 0) close(fds[e]);
+    }
+}
+
+void perfCounters::start()
+{
+    for (int e = 0; e < PerfEvent::NUM_PERF_EVENTS; e++) {
+        if (fds[e] < 0) continue;
+        ioctl(fds[e], PERF_EVENT_IOC_RESET, 0);
+        ioctl(fds[e], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void perfCounters::stop()
+{
+    for (int e = 0; e < PerfEvent::NUM_PERF_EVENTS; e++) {
+        if (fds[e] < 0) continue;
+        ioctl(fds[e], PERF_EVENT_IOC_DISABLE, 0);
+        // Layout of PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING
+        struct { uint64_t value, enabled, running; } data;
+        if (read(fds[e], &data, sizeof(data)) == sizeof(data)) {
+            values[e] += static_cast<long long>(data.value);
+            enabled[e] += static_cast<long long>(data.enabled);
+            running[e] += static_cast<long long>(data.running);
+        }
+    }
+}
+
+#else
+
+perfCounters::perfCounters()
+{
+    for (int e = 0; e < PerfEvent::NUM_PERF_EVENTS; e++) {
+        fds[e] = -1;
+        values[e] = -1;
+        enabled[e] = 0;
+        running[e] = 0;
+    }
+}
+
+perfCounters::~perfCounters() {}
+
+void perfCounters::start() {}
+
+void perfCounters::stop() {}
+
+#endif
+
+bool perfCounters::isAvailable() const
+{
+    for (int e = 0; e < PerfEvent::NUM_PERF_EVENTS; e++) {
+        if (fds[e] >= 0) return true;
+    }
+    return false;
+}
+
+long long perfCounters::get(PerfEvent event) const
+{
+    if (values[event] < 0) return -1;
+    if (running[event] == enabled[event]) return values[event];
+    // Multiplexed out for the whole run: nothing to extrapolate from
+    if (running[event] == 0) return -1;
+    return static_cast<long long>(static_cast<double>(values[event]) * enabled[event] / running[event]);
+}
+
+json perfToJson(const std::vector<std::vector<long long>>& counters)
+{
+    const int n = PerfEvent::NUM_PERF_EVENTS;
+    json result;
+    json workers = json::array();
+    std::vector<long long> totals(n, -1), enabled(n, 0), running(n, 0);
+    auto scaling = [](long long enabledTime, long long runningTime) {
+        return runningTime > 0 ? static_cast<double>(enabledTime) / runningTime : 1.0;
+    };
+    for (auto& worker : counters) {
+        json w;
+        json workerScaling;
+        for (int e = 0; e < n; e++) {
+            std::string name = getPerfEventName(static_cast<PerfEvent>(e));
+            if (worker[e] < 0) {
+                w[name] = nullptr;
+                workerScaling[name] = nullptr;
+                continue;
+            }
+            w[name] = worker[e];
+            workerScaling[name] = scaling(worker[n + e], worker[2 * n + e]);
+            totals[e] = (totals[e] < 0 ? 0 : totals[e]) + worker[e];
+            enabled[e] += worker[n + e];
+            running[e] += worker[2 * n + e];
+        }
+        w["scaling"] = workerScaling;
+        workers.emplace_back(w);
+    }
+    bool available = false;
+    json totalScaling;
+    for (int e = 0; e < n; e++) {
+        std::string name = getPerfEventName(static_cast<PerfEvent>(e));
+        if (totals[e] < 0) {
+            result[name] = nullptr;
+            totalScaling[name] = nullptr;
+        } else {
+            result[name] = totals[e];
+            totalScaling[name] = scaling(enabled[e], running[e]);
+            available = true;
+        }
+    }
+    result["available"] = available;
+    result["scaling"] = totalScaling;
+    result["workers"] = workers;
+    return result;
+}
@@ -0,0 +1,227 @@
+#include "ws/lib.hpp"
+#include "ws/scheduler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+///////////////////////
+// Vertex reordering //
+///////////////////////
+
+// The generators number the tori row-major, so the neighbours of a vertex
+// along the other dimensions are shape (or shape^2) ids away and their
+// colors and parents sit in other cache lines. The orders below relabel
+// the graph so that vertices close in the graph get close ids.
+
+namespace {
+
+// Edges in both directions, so that the orders see the weak structure of
+// directed graphs too.
+int degree(graph& g, int v)
+{
+    int d = static_cast<int>(g.getNeighbours(v).size());
+    return g.isDirected() ? d + static_cast<int>(g.getChildren(v).size()) : d;
+}
+
+template <typename F>
+void forEachAdjacent(graph& g, int v, F f)
+{
+    for (int w : g.getNeighbours(v)) f(w);
+    if (g.isDirected()) {
+        for (int w : g.getChildren(v)) f(w);
+    }
+}
+
+// BFS from start that appends the discovered vertices to order. With
+// byDegree, the new vertices of each one are sorted by degree (Cuthill-McKee).
+int bfsFrom(graph& g, int start, std::vector<bool>& visited, std::vector<int>& order,
+            const std::vector<int>& degrees, bool byDegree)
+{
+    size_t head = order.size();
+    visited[start] = true;
+    order.emplace_back(start);
+    int last = start;
+    while (head < order.size()) {
+        int v = order[head++];
+        last = v;
+        size_t first = order.size();
+        forEachAdjacent(g, v, [&](int w) {
+            if (visited[w]) return;
+            visited[w] = true;
+            order.emplace_back(w);
+        });
+        if (byDegree) {
+            std::stable_sort(order.begin() + first, order.end(),
+                             [&](int a, int b) { return degrees[a] < degrees[b]; });
+        }
+    }
+    return last;
+}
+
+// Vertex of a component far from everything else (George and Liu): BFS
+// again from the last vertex found until it stops changing. A few rounds
+// are enough. scratch is all false and is left that way.
+int pseudoPeripheral(graph& g, int start, const std::vector<int>& degrees, std::vector<bool>& scratch)
+{
+    std::vector<int> order;
+    for (int round = 0; round < 4; round++) {
+        order.clear();
+        int next = bfsFrom(g, start, scratch, order, degrees, true);
+        for (int v : order) scratch[v] = false;
+        if (next == start) break;
+        start = next;
+    }
+    return start;
+}
+
+// Hilbert index of the n coordinates of X, bits bits each. Skilling,
+// "Programming the Hilbert curve" (2004): the coordinates are turned in
+// place into the transposed index, whose bits are then interleaved.
+uint64_t hilbertIndex(uint32_t* X, int n, int bits)
+{
+    uint32_t M = 1u << (bits - 1);
+    for (uint32_t Q = M; Q > 1; Q >>= 1) {
+        uint32_t P = Q - 1;
+        for (int i = 0; i < n; i++) {
+            if (X[i] & Q) {
+                X[0] ^= P;
+            } else {
+                uint32_t t = (X[0] ^ X[i]) & P;
+                X[0] ^= t;
+                X[i] ^= t;
+            }
+        }
+    }
+    for (int i = 1; i < n; i++) X[i] ^= X[i - 1];
+    uint32_t t = 0;
+    for (uint32_t Q = M; Q > 1; Q >>= 1) {
+        if (X[n - 1] & Q) t ^= Q - 1;
+    }
+    for (int i = 0; i < n; i++) X[i] ^= t;
+    uint64_t index = 0;
+    for (int b = bits - 1; b >= 0; b--) {
+        for (int i = 0; i < n; i++) index = (index << 1) | ((X[i] >> b) & 1);
+    }
+    return index;
+}
+
+std::vector<int> hilbertOrder(graph& g, ws::Scheduler& s)
+{
+    const int numVertices = g.getNumberVertices();
+    int dims;
+    switch (g.getType()) {
+    case GraphType::TORUS_2D:
+    case GraphType::TORUS_2D_60:
+        dims = 2;
+        break;
+    case GraphType::TORUS_3D:
+    case GraphType::TORUS_3D_40:
+        dims = 3;
+        break;
+    default:
+        throw std::invalid_argument("HILBERT only applies to the tori");
+    }
+    int shape = static_cast<int>(std::lround(std::pow(numVertices, 1.0 / dims)));
+    int bits = 1;
+    while ((1 << bits) < shape) bits++;
+    std::vector<uint64_t> keys(numVertices);
+    ws::parallelFor(s, 0, numVertices, [&](int v) {
+        // Row-major ids: the last coordinate changes fastest
+        uint32_t X[3];
+        int rest = v;
+        for (int d = dims - 1; d >= 0; d--) {
+            X[d] = rest % shape;
+            rest /= shape;
+        }
+        keys[v] = hilbertIndex(X, dims, bits);
+    });
+    std::vector<int> order(numVertices);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return keys[a] < keys[b]; });
+    return order;
+}
+
+}
+
+reordering vertexOrder(graph& g, ReorderType type, int numThreads)
+{
+    const int n = g.getNumberVertices();
+    ws::Scheduler s(AlgorithmType::CHASELEV, std::max(1, numThreads), 64, 4096);
+    std::vector<int> order;
+    order.reserve(n);
+    if (type == ReorderType::HILBERT) {
+        order = hilbertOrder(g, s);
+    } else if (type == ReorderType::NO_REORDER) {
+        order.resize(n);
+        std::iota(order.begin(), order.end(), 0);
+    } else {
+        std::vector<int> degrees(n);
+        ws::parallelFor(s, 0, n, [&](int v) { degrees[v] = degree(g, v); });
+        std::vector<bool> visited(n, false);
+        if (type == ReorderType::BFS_ORDER) {
+            // The root first, then whatever it did not reach
+            int root = n > 0 ? g.getRoot() : 0;
+            for (int v = root; v < root + n; v++) {
+                if (!visited[v % n]) bfsFrom(g, v % n, visited, order, degrees, false);
+            }
+        } else {
+            // Components from their lowest degree vertex
+            std::vector<int> starts(n);
+            std::iota(starts.begin(), starts.end(), 0);
+            std::stable_sort(starts.begin(), starts.end(),
+                             [&](int a, int b) { return degrees[a] < degrees[b]; });
+            std::vector<bool> scratch(n, false);
+            for (int v : starts) {
+                if (visited[v]) continue;
+                bfsFrom(g, pseudoPeripheral(g, v, degrees, scratch), visited, order, degrees, true);
+            }
+            std::reverse(order.begin(), order.end());
+        }
+    }
+    reordering result;
+    result.oldId = std::move(order);
+    result.newId.assign(n, -1);
+    ws::parallelFor(s, 0, n, [&](int i) { result.newId[result.oldId[i]] = i; });
+    return result;
+}
+
+graph relabel(graph& g, const reordering& order)
+{
+    const int n = g.getNumberVertices();
+    graph relabeled(g.isDirected(), n > 0 ? order.newId[g.getRoot()] : 0, n, g.getType());
+    // Following the new ids, so the adjacency lists are also allocated in order
+    for (int i = 0; i < n; i++) {
+        int v = order.oldId[i];
+        // Like the generators, undirected edges are added from both ends, so
+        // getNumberEdges (and the GTEPS derived from it) does not change
+        for (int w : g.getNeighbours(v)) relabeled.addEdge(i, order.newId[w]);
+    }
+    return relabeled;
+}
+
+std::vector<int> toOriginal(const reordering& order, const std::vector<int>& values)
+{
+    std::vector<int> original(values.size());
+    for (size_t v = 0; v < values.size(); v++) original[order.oldId[v]] = values[v];
+    return original;
+}
+
+std::vector<int> verticesToOriginal(const reordering& order, const std::vector<int>& vertices)
+{
+    std::vector<int> original(vertices.size());
+    for (size_t v = 0; v < vertices.size(); v++) {
+        int w = vertices[v];
+        original[order.oldId[v]] = w >= 0 ? order.oldId[w] : w;
+    }
+    return original;
+}
+
+int bandwidth(graph& g)
+{
+    int result = 0;
+    for (int v = 0; v < g.getNumberVertices(); v++) {
+        for (int w : g.getNeighbours(v)) result = std::max(result, std::abs(v - w));
+    }
+    return result;
+}
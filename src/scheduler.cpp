@@ -0,0 +1,243 @@
+#include "ws/scheduler.hpp"
+
+namespace ws {
+
+//////////////////////////////
+// Fork-join task scheduler //
+//////////////////////////////
+
+namespace {
+
+thread_local Scheduler* currentScheduler = nullptr;
+thread_local int currentWorker = -1;
+
+}
+
+Scheduler::Scheduler(AlgorithmType algType, int numThreads, int tasksPerWorker,
+                     int dequeCapacity) :
+    algType_(algType),
+    special_(isSpecial(algType)),
+    numThreads_(numThreads),
+    tasksPerWorker_(tasksPerWorker)
+{
+    if (algType == AlgorithmType::SIMPLE || algType == AlgorithmType::LAST) {
+        throw std::invalid_argument("Scheduler needs a work-stealing algorithm");
+    }
+    if (numThreads < 1 || tasksPerWorker < 1) {
+        throw std::invalid_argument("Scheduler needs at least one worker and one task slot");
+    }
+    workers_ = std::make_unique<Worker[]>(numThreads);
+    for (int i = 0; i < numThreads; i++) {
+        Worker& w = workers_[i];
+        w.deque = workStealingAlgorithmFactory(algType, dequeCapacity, numThreads);
+        w.slots = new TaskSlot[tasksPerWorker];
+        w.freeSlots.reserve(tasksPerWorker);
+        for (int j = tasksPerWorker - 1; j >= 0; j--) {
+            w.freeSlots.push_back(i * tasksPerWorker + j);
+        }
+        w.rng.seed(i + 1);
+    }
+    for (int i = 1; i < numThreads; i++) {
+        threads_.emplace_back(&Scheduler::workerLoop, this, i);
+    }
+}
+
+Scheduler::~Scheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutdown_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& th : threads_) th.join();
+    for (int i = 0; i < numThreads_; i++) {
+        delete workers_[i].deque;
+        delete[] workers_[i].slots;
+    }
+}
+
+SchedulerStats Scheduler::stats() const
+{
+    SchedulerStats total;
+    for (int i = 0; i < numThreads_; i++) {
+        const SchedulerStats& s = workers_[i].stats;
+        total.spawns += s.spawns;
+        total.inlined += s.inlined;
+        total.executed += s.executed;
+        total.steals += s.steals;
+        total.duplicates += s.duplicates;
+    }
+    return total;
+}
+
+bool Scheduler::schedule(std::coroutine_handle<> handle)
+{
+    return trySpawn(nullptr, [handle]() { handle.resume(); });
+}
+
+bool Scheduler::localEmpty()
+{
+    workStealingAlgorithm* deque = workers_[workerId()].deque;
+    return special_ ? deque->isEmpty(workerId()) : deque->isEmpty();
+}
+
+int Scheduler::workerId()
+{
+    return currentWorker;
+}
+
+Scheduler* Scheduler::current()
+{
+    return currentScheduler;
+}
+
+void Scheduler::begin()
+{
+    if (currentScheduler != nullptr) {
+        throw std::logic_error("Scheduler::run called from inside a run");
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        numParked_ = 0;
+        epoch_++;
+        active_.store(true, release);
+    }
+    wake_.notify_all();
+    currentScheduler = this;
+    currentWorker = 0;
+}
+
+void Scheduler::end()
+{
+    currentScheduler = nullptr;
+    currentWorker = -1;
+    active_.store(false, release);
+    std::unique_lock<std::mutex> lock(mutex_);
+    parked_.wait(lock, [this] { return numParked_ == numThreads_ - 1; });
+}
+
+void Scheduler::workerLoop(int id)
+{
+    long long seen = 0;
+    currentScheduler = this;
+    currentWorker = id;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return shutdown_ || epoch_ != seen; });
+            if (shutdown_) return;
+            seen = epoch_;
+        }
+        while (active_.load(acquire)) {
+            if (!runOne(id)) std::this_thread::yield();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            numParked_++;
+        }
+        parked_.notify_one();
+    }
+}
+
+int Scheduler::allocate(int id)
+{
+    Worker& w = workers_[id];
+    if (w.freeSlots.empty()) {
+        // Take back every slot other workers finished since the last time.
+        int index = w.remoteFree.exchange(-1, acquire);
+        while (index >= 0) {
+            w.freeSlots.push_back(index);
+            index = w.slots[index % tasksPerWorker_].next;
+        }
+        if (w.freeSlots.empty()) return -1;
+    }
+    int index = w.freeSlots.back();
+    w.freeSlots.pop_back();
+    return index;
+}
+
+void Scheduler::freeSlot(int index, int id)
+{
+    int owner = index / tasksPerWorker_;
+    Worker& w = workers_[owner];
+    TaskSlot& slot = w.slots[index % tasksPerWorker_];
+    slot.state.store(TaskSlot::FREE, release);
+    if (owner == id) {
+        w.freeSlots.push_back(index);
+        return;
+    }
+    // Many producers, one consumer that swaps the whole list: no ABA.
+    int head = w.remoteFree.load(relaxed);
+    do {
+        slot.next = head;
+    } while (!w.remoteFree.compare_exchange_weak(head, index, release, relaxed));
+}
+
+void Scheduler::push(int id, int index)
+{
+    workStealingAlgorithm* deque = workers_[id].deque;
+    if (special_) deque->put(index, id);
+    else deque->put(index);
+}
+
+int Scheduler::pop(int id)
+{
+    workStealingAlgorithm* deque = workers_[id].deque;
+    return special_ ? deque->take(id) : deque->take();
+}
+
+int Scheduler::stealFrom(int id)
+{
+    if (numThreads_ == 1) return EMPTY;
+    Worker& w = workers_[id];
+    int victim = std::uniform_int_distribution<int>(0, numThreads_ - 2)(w.rng);
+    if (victim >= id) victim++;
+    workStealingAlgorithm* deque = workers_[victim].deque;
+    int index = special_ ? deque->steal(id) : deque->steal();
+    if (index >= 0) w.stats.steals++;
+    return index;
+}
+
+bool Scheduler::execute(int index, int id)
+{
+    TaskSlot& slot = workers_[index / tasksPerWorker_].slots[index % tasksPerWorker_];
+    int expected = TaskSlot::READY;
+    if (!slot.state.compare_exchange_strong(expected, TaskSlot::RUNNING,
+                                            std::memory_order_acq_rel, relaxed)) {
+        workers_[id].stats.duplicates++;
+        return false;
+    }
+    slot.run(slot.buffer);
+    workers_[id].stats.executed++;
+    TaskGroup* group = slot.group;
+    freeSlot(index, id);
+    // The group may be destroyed as soon as this reaches zero.
+    if (group != nullptr) group->pending_.fetch_sub(1, release);
+    return true;
+}
+
+bool Scheduler::runOne(int id)
+{
+    int index = pop(id);
+    if (index < 0) index = stealFrom(id);
+    return index >= 0 && execute(index, id);
+}
+
+TaskGroup::TaskGroup() : scheduler_(Scheduler::current())
+{
+    if (scheduler_ == nullptr) {
+        throw std::logic_error("TaskGroup used outside of Scheduler::run");
+    }
+}
+
+TaskGroup::~TaskGroup()
+{
+    sync();
+}
+
+void TaskGroup::sync()
+{
+    scheduler_->helpUntil([this] { return pending_.load(acquire) == 0; });
+}
+
+} // namespace ws
@@ -0,0 +1,129 @@
+#include "ws/lib.hpp"
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define WS_X86_SIMD
+#endif
+
+//////////////////////////////
+// Neighbour filtering SIMD //
+//////////////////////////////
+
+// The colors are one or two bytes, and the gathers load 32-bit words, so
+// every lane reads the color of its neighbour plus the bytes after it
+// (colorArray leaves room past the last vertex) and masks them away. The
+// vector kernels are compiled for their instruction set with the target
+// attribute and only called after CPUID says it is there, so the rest of
+// the library keeps the default flags.
+
+namespace {
+
+int scalarFilter(const colorArray& colors, const int* first, int n, int* out)
+{
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        if (colors.load(first[i], relaxed) == 0) out[count++] = first[i];
+    }
+    return count;
+}
+
+#ifdef WS_X86_SIMD
+
+// The last (or only, on the tori) group of fewer than 8 or 16 neighbours
+// goes through masked loads and gathers, so lanes past n touch nothing.
+
+__attribute__((target("avx2")))
+int avx2Filter(const colorArray& colors, const int* first, int n, int* out)
+{
+    const int* base = reinterpret_cast<const int*>(colors.raw());
+    const __m256i mask = _mm256_set1_epi32(colors.wide() ? 0xFFFF : 0xFF);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    int count = 0;
+    for (int i = 0; i < n; i += 8) {
+        __m256i active = _mm256_cmpgt_epi32(_mm256_set1_epi32(n - i), lane);
+        __m256i vertices = _mm256_maskload_epi32(first + i, active);
+        __m256i words = colors.wide() ? _mm256_mask_i32gather_epi32(zero, base, vertices, active, 2)
+                                      : _mm256_mask_i32gather_epi32(zero, base, vertices, active, 1);
+        __m256i uncolored = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(words, mask), zero), active);
+        unsigned lanes = _mm256_movemask_ps(_mm256_castsi256_ps(uncolored));
+        while (lanes != 0) {
+            out[count++] = first[i + __builtin_ctz(lanes)];
+            lanes &= lanes - 1;
+        }
+    }
+    return count;
+}
+
+__attribute__((target("avx512f")))
+int avx512Filter(const colorArray& colors, const int* first, int n, int* out)
+{
+    const int* base = reinterpret_cast<const int*>(colors.raw());
+    const __m512i mask = _mm512_set1_epi32(colors.wide() ? 0xFFFF : 0xFF);
+    const __m512i zero = _mm512_setzero_si512();
+    int count = 0;
+    for (int i = 0; i < n; i += 16) {
+        __mmask16 active = n - i >= 16 ? 0xFFFF : static_cast<__mmask16>((1u << (n - i)) - 1);
+        __m512i vertices = _mm512_maskz_loadu_epi32(active, first + i);
+        __m512i words = colors.wide() ? _mm512_mask_i32gather_epi32(zero, active, vertices, base, 2)
+                                      : _mm512_mask_i32gather_epi32(zero, active, vertices, base, 1);
+        __mmask16 uncolored = _mm512_mask_testn_epi32_mask(active, words, mask);
+        _mm512_mask_compressstoreu_epi32(out + count, uncolored, vertices);
+        count += __builtin_popcount(uncolored);
+    }
+    return count;
+}
+
+#endif
+
+}
+
+bool simdKernelSupported(SimdKernel kernel)
+{
+    switch (kernel) {
+    case SimdKernel::SCALAR_KERNEL:
+        return true;
+#ifdef WS_X86_SIMD
+    case SimdKernel::AVX2_KERNEL:
+        return __builtin_cpu_supports("avx2");
+    case SimdKernel::AVX512_KERNEL:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+SimdKernel bestSimdKernel()
+{
+    static const SimdKernel best = simdKernelSupported(SimdKernel::AVX512_KERNEL) ? SimdKernel::AVX512_KERNEL
+        : simdKernelSupported(SimdKernel::AVX2_KERNEL) ? SimdKernel::AVX2_KERNEL
+        : SimdKernel::SCALAR_KERNEL;
+    return best;
+}
+
+std::string getSimdKernelName(SimdKernel kernel)
+{
+    switch (kernel) {
+    case SimdKernel::SCALAR_KERNEL:
+        return "SCALAR";
+    case SimdKernel::AVX2_KERNEL:
+        return "AVX2";
+    case SimdKernel::AVX512_KERNEL:
+        return "AVX512";
+    }
+    return "UNKNOWN";
+}
+
+int unvisitedNeighbours(const colorArray& colors, const int* first, int n, int* out, SimdKernel kernel)
+{
+    switch (kernel) {
+#ifdef WS_X86_SIMD
+    case SimdKernel::AVX2_KERNEL:
+        return avx2Filter(colors, first, n, out);
+    case SimdKernel::AVX512_KERNEL:
+        return avx512Filter(colors, first, n, out);
+#endif
+    default:
+        return scalarFilter(colors, first, n, out);
+    }
+}
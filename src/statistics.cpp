@@ -0,0 +1,39 @@
+#include "ws/lib.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+////////////////////////////////
+// Statistics of experiments //
+////////////////////////////////
+
+// Two-sided 95% critical values of Student's t distribution for 1..30
+// degrees of freedom; beyond that the normal approximation is used.
+static const double T_95[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+json summarize(std::vector<double> values)
+{
+    json result;
+    size_t n = values.size();
+    result["n"] = n;
+    if (n == 0) return result;
+    std::sort(values.begin(), values.end());
+    double mean = std::accumulate(values.begin(), values.end(), 0.0) / n;
+    double median = n % 2 == 1 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+    double sq = 0;
+    for (double v : values) sq += (v - mean) * (v - mean);
+    double stddev = n > 1 ? std::sqrt(sq / (n - 1)) : 0.0;
+    double t = n > 1 ? (n - 1 <= 30 ? T_95[n - 2] : 1.96) : 0.0;
+    double halfWidth = n > 1 ? t * stddev / std::sqrt(static_cast<double>(n)) : 0.0;
+    result["min"] = values.front();
+    result["max"] = values.back();
+    result["median"] = median;
+    result["mean"] = mean;
+    result["stddev"] = stddev;
+    result["ci95"] = {mean - halfWidth, mean + halfWidth};
+    return result;
+}
@@ -0,0 +1,135 @@
+#include "ws/lib.hpp"
+
+/////////////////////////////
+// Per-worker event tracer //
+/////////////////////////////
+
+std::string getTraceEventName(TraceEventType type)
+{
+    switch (type) {
+    case TraceEventType::TRACE_PUT:
+        return "put";
+    case TraceEventType::TRACE_TAKE:
+        return "take";
+    case TraceEventType::TRACE_STEAL_ATTEMPT:
+        return "steal-attempt";
+    case TraceEventType::TRACE_STEAL_SUCCESS:
+        return "steal-success";
+    case TraceEventType::TRACE_IDLE_BEGIN:
+    case TraceEventType::TRACE_IDLE_END:
+        return "idle";
+    default:
+        return "unknown";
+    }
+}
+
+traceBuffer::traceBuffer(size_t capacity, std::chrono::steady_clock::time_point origin)
+    : origin(origin)
+{
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    events = std::make_unique<traceEvent[]>(size);
+    mask = size - 1;
+}
+
+std::vector<traceEvent> traceBuffer::snapshot() const
+{
+    size_t last = next.load(acquire);
+    size_t first = last > mask + 1 ? last - (mask + 1) : 0;
+    std::vector<traceEvent> result;
+    result.reserve(last - first);
+    for (size_t i = first; i < last; i++) result.emplace_back(events[i & mask]);
+    return result;
+}
+
+size_t traceBuffer::dropped() const
+{
+    size_t last = next.load(acquire);
+    return last > mask + 1 ? last - (mask + 1) : 0;
+}
+
+tracer::tracer(int numWorkers, size_t capacity) : origin(std::chrono::steady_clock::now())
+{
+    for (int i = 0; i < numWorkers; i++) {
+        buffers.emplace_back(std::make_unique<traceBuffer>(capacity, origin));
+    }
+}
+
+traceBuffer* tracer::worker(int id)
+{
+    return buffers[id].get();
+}
+
+json tracer::toChromeTrace() const
+{
+    json events = json::array();
+    for (size_t w = 0; w < buffers.size(); w++) {
+        int tid = static_cast<int>(w);
+        events.push_back({{"name", "thread_name"}, {"ph", "M"}, {"pid", 0}, {"tid", tid},
+                          {"args", {{"name", string_format("worker %d", tid)}}}});
+        bool idle = false;
+        double last = 0;
+        for (auto& e : buffers[w]->snapshot()) {
+            TraceEventType type = static_cast<TraceEventType>(e.type);
+            double ts = e.timestamp / 1000.0; // Chrome expects microseconds
+            last = ts;
+            json event = {{"name", getTraceEventName(type)}, {"pid", 0}, {"tid", tid}, {"ts", ts}};
+            switch (type) {
+            case TraceEventType::TRACE_IDLE_BEGIN:
+                idle = true;
+                event["ph"] = "B";
+                break;
+            case TraceEventType::TRACE_IDLE_END:
+                // The beginning may have been overwritten in the ring
+                if (!idle) continue;
+                idle = false;
+                event["ph"] = "E";
+                break;
+            case TraceEventType::TRACE_STEAL_ATTEMPT:
+                event["ph"] = "i";
+                event["s"] = "t";
+                event["args"] = {{"victim", e.value}};
+                break;
+            default:
+                event["ph"] = "i";
+                event["s"] = "t";
+                event["args"] = {{"task", e.value}};
+            }
+            events.emplace_back(event);
+        }
+        if (idle) {
+            events.push_back({{"name", "idle"}, {"ph", "E"}, {"pid", 0}, {"tid", tid}, {"ts", last}});
+        }
+    }
+    json trace;
+    trace["traceEvents"] = events;
+    trace["displayTimeUnit"] = "ns";
+    return trace;
+}
+
+json tracer::summary() const
+{
+    json workers = json::array();
+    for (auto& buffer : buffers) {
+        json w;
+        long long idleStart = -1, idleTime = 0;
+        std::vector<long long> counts(TraceEventType::TRACE_IDLE_END + 1, 0);
+        for (auto& e : buffer->snapshot()) {
+            counts[e.type]++;
+            if (e.type == TraceEventType::TRACE_IDLE_BEGIN) {
+                idleStart = e.timestamp;
+            } else if (e.type == TraceEventType::TRACE_IDLE_END && idleStart >= 0) {
+                idleTime += e.timestamp - idleStart;
+                idleStart = -1;
+            }
+        }
+        w["puts"] = counts[TraceEventType::TRACE_PUT];
+        w["takes"] = counts[TraceEventType::TRACE_TAKE];
+        w["stealAttempts"] = counts[TraceEventType::TRACE_STEAL_ATTEMPT];
+        w["stealSuccesses"] = counts[TraceEventType::TRACE_STEAL_SUCCESS];
+        w["idleTime"] = idleTime;
+        w["dropped"] = buffer->dropped();
+        workers.emplace_back(w);
+    }
+    return workers;
+}
@@ -360,6 +360,20 @@ workStealingAlgorithm* workStealingAlgorithmFactory(AlgorithmType algType, int c
     switch (algType) {
     case AlgorithmType::CILK:
         return new cilk(capacity);
+    case AlgorithmType::CILK_TTAS:
+        return new cilkTTAS(capacity);
+    case AlgorithmType::CILK_TICKET:
+        return new cilkTicket(capacity);
+    case AlgorithmType::CILK_MCS:
+        return new cilkMCS(capacity);
+    case AlgorithmType::CHASELEV_FENCE_FREE:
+        return new chaselevFenceFree(capacity);
+    case AlgorithmType::CILK_FENCE_FREE:
+        return new cilkFenceFree(capacity);
+    case AlgorithmType::CHASELEV_MEMBARRIER:
+        return new chaselevMembarrier(capacity);
+    case AlgorithmType::CILK_MEMBARRIER:
+        return new cilkMembarrier(capacity);
     case AlgorithmType::CHASELEV:
         return new chaselev(capacity);
     case AlgorithmType::IDEMPOTENT_FIFO:
@@ -376,16 +390,60 @@ workStealingAlgorithm* workStealingAlgorithmFactory(AlgorithmType algType, int c
         return new bwsncmult(capacity, numThreads);
     case AlgorithmType::WS_NC_MULT_LA_OPT:
         return new wsncmultla(512, capacity, numThreads);
+    case AlgorithmType::B_WS_NC_MULT_LA_OPT:
+        return new bwsncmultla(512, capacity, numThreads);
+    case AlgorithmType::WS_NC_MULT_RING_OPT:
+        return new wsncmultring(capacity, numThreads);
+    case AlgorithmType::SIMPLE:
     case AlgorithmType::LAST:
         break;
-        // case AlgorithmType::SIMPLE:
-        //     break;
-        // case AlgorithmType::B_WS_NC_MULT_LA_OPT:
-        //     break;
     }
     return new workStealingAlgorithm();
 }
 
+std::vector<workStealingAlgorithm*> makeDeques(ws::Params& params, int capacity)
+{
+    std::vector<workStealingAlgorithm*> algs;
+    for (int i = 0; i < params.numThreads; i++) {
+        algs.emplace_back(workStealingAlgorithmFactory(params.algType, capacity, params.numThreads));
+    }
+    return algs;
+}
+
+void runWorkers(int numThreads, const std::function<void(int)>& func)
+{
+    const int numCores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; i++) {
+        threads.emplace_back(std::thread(func, i));
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(i % numCores, &cpuset);
+        int rc = pthread_setaffinity_np(threads[i].native_handle(),
+                                        sizeof(cpu_set_t), &cpuset);
+        if (rc != 0) {
+            std::cerr << "Error calling pthread_setaffinity_np: " << rc << "\n";
+        }
+    }
+    for (std::thread &th : threads) {
+        if (th.joinable()) th.join();
+    }
+}
+
+int stealAny(std::vector<workStealingAlgorithm*>& algs, bool special, int id, std::mt19937& rng)
+{
+    int numThreads = static_cast<int>(algs.size());
+    if (numThreads == 1) return EMPTY;
+    int start = std::uniform_int_distribution<int>(0, numThreads - 1)(rng);
+    for (int k = 0; k < numThreads; k++) {
+        int victim = (start + k) % numThreads;
+        if (victim == id) continue;
+        int task = dequeHandle(algs[victim], special, id).steal();
+        if (task >= 0) return task;
+    }
+    return EMPTY;
+}
+
 graph graphFactory(GraphType type, int shape, bool directed)
 {
     switch(type) {
@@ -414,6 +472,15 @@ graph buildFromParents(std::atomic<int>* parents, int totalParents, int root, bo
     return g;
 }
 
+graph buildFromParents(int* parents, int totalParents, int root, bool directed)
+{
+    graph g(directed, root, totalParents, GraphType::RANDOM);
+    for (int i = 0; i < totalParents; i++) {
+        g.addEdge(i, parents[i]);
+    }
+    return g;
+}
+
 
 bool isCyclic(graph& g, std::unique_ptr<bool[]>& visited)
 {
@@ -508,7 +575,7 @@ int* stubSpanning(graph& g, int size)
 {
     std::random_device rd;
     std::mt19937 gen(rd());
-    std::uniform_int_distribution<> distrib(1, g.getNumberVertices());
+    std::uniform_int_distribution<> distrib(0, g.getNumberVertices() - 1);
     int* stubSpanning = new int[size];
     std::fill(stubSpanning, stubSpanning + size, -1);
     int randomVal = distrib(gen);
@@ -518,6 +585,8 @@ int* stubSpanning(graph& g, int size)
     s.push_front(randomVal);
     int idx, tmpVal;
     while (i < size) {
+        // The component ran out of vertices, continue from another one
+        if (s.empty()) s.push_front(distrib(gen));
         idx = s.front();
         s.pop_front();
         neighbors = g.getNeighbours(idx);
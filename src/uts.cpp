@@ -0,0 +1,141 @@
+#include "ws/lib.hpp"
+#include "ws/scheduler.hpp"
+#include <cmath>
+#include <cstdint>
+
+////////////////////////////
+// Unbalanced Tree Search //
+////////////////////////////
+
+// The number of children of a node follows from a hash of the node, and the
+// hash of every child from the hash of its parent and its position, so the
+// tree is the same on every run and every number of workers while no
+// worker can tell how big a subtree is before exploring it. UTS derives the
+// hashes with SHA-1; a SplitMix64 mix gives the same independence between
+// siblings at a fraction of the cost per node.
+
+namespace {
+
+struct utsNode {
+    uint64_t state;
+    int depth;
+};
+
+struct alignas(64) utsCounters {
+    long long nodes = 0;
+    long long leaves = 0;
+    int maxDepth = 0;
+};
+
+uint64_t mix(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+utsNode rootOf(const ws::Params& params)
+{
+    return utsNode{mix(static_cast<uint64_t>(params.utsSeed)), 0};
+}
+
+utsNode childOf(const utsNode& parent, int i)
+{
+    return utsNode{mix(parent.state ^ (0x9e3779b97f4a7c15ULL * (i + 1))), parent.depth + 1};
+}
+
+// Uniform in [0, 1) from the 53 high bits of the hash.
+double uniform(const utsNode& node)
+{
+    return static_cast<double>(node.state >> 11) * 0x1.0p-53;
+}
+
+int numChildren(const ws::Params& params, const utsNode& node)
+{
+    if (params.utsTree == UtsTreeType::BINOMIAL) {
+        if (node.depth == 0) return static_cast<int>(params.utsBranching);
+        return uniform(node) < params.utsQ ? params.utsM : 0;
+    }
+    if (node.depth >= params.utsDepth) return 0;
+    // Geometric distribution of mean utsBranching
+    double p = 1.0 / (1.0 + params.utsBranching);
+    return static_cast<int>(std::floor(std::log(1.0 - uniform(node)) / std::log(1.0 - p)));
+}
+
+int count(const ws::Params& params, const utsNode& node, utsCounters& c)
+{
+    int n = numChildren(params, node);
+    c.nodes++;
+    if (n == 0) c.leaves++;
+    c.maxDepth = std::max(c.maxDepth, node.depth);
+    return n;
+}
+
+void visit(const ws::Params& params, utsNode node, utsCounters* counters)
+{
+    int n = count(params, node, counters[ws::Scheduler::workerId()]);
+    if (n == 0) return;
+    ws::TaskGroup group;
+    for (int i = 0; i < n; i++) {
+        utsNode child = childOf(node, i);
+        group.spawn([&params, child, counters]() { visit(params, child, counters); });
+    }
+    group.sync();
+}
+
+utsResult merge(const utsCounters* counters, int numWorkers, Report& report)
+{
+    utsResult result;
+    int* processors = new int[report.numProcessors_]();
+    for (int i = 0; i < numWorkers; i++) {
+        result.nodes += counters[i].nodes;
+        result.leaves += counters[i].leaves;
+        result.maxDepth = std::max(result.maxDepth, counters[i].maxDepth);
+        processors[i] = static_cast<int>(counters[i].nodes);
+    }
+    report.processors_ = processors;
+    report.expansions = static_cast<int>(result.nodes);
+    return result;
+}
+
+}
+
+utsResult sequentialUts(Report& report, ws::Params& params)
+{
+    utsCounters c;
+    std::vector<utsNode> stack;
+    int puts = 0;
+    auto t_start = std::chrono::high_resolution_clock::now();
+    stack.emplace_back(rootOf(params));
+    puts++;
+    while (!stack.empty()) {
+        utsNode node = stack.back();
+        stack.pop_back();
+        int n = count(params, node, c);
+        for (int i = 0; i < n; i++) stack.emplace_back(childOf(node, i));
+        puts += n;
+    }
+    auto t_end = std::chrono::high_resolution_clock::now();
+    report.executionTime = std::chrono::duration<long, std::nano>(t_end - t_start).count();
+    report.puts = puts;
+    report.takes = puts;
+    return merge(&c, 1, report);
+}
+
+utsResult uts(Report& report, ws::Params& params)
+{
+    if (params.algType == AlgorithmType::SIMPLE) return sequentialUts(report, params);
+    ws::Scheduler s(params.algType, params.numThreads);
+    std::unique_ptr<utsCounters[]> counters(new utsCounters[params.numThreads]);
+    utsNode root = rootOf(params);
+    auto t_start = std::chrono::high_resolution_clock::now();
+    s.run([&]() { visit(params, root, counters.get()); });
+    auto t_end = std::chrono::high_resolution_clock::now();
+    report.executionTime = std::chrono::duration<long, std::nano>(t_end - t_start).count();
+    ws::SchedulerStats stats = s.stats();
+    report.puts = static_cast<int>(stats.spawns - stats.inlined);
+    report.steals = static_cast<int>(stats.steals);
+    report.takes = static_cast<int>(stats.executed - stats.steals);
+    return merge(counters.get(), params.numThreads, report);
+}
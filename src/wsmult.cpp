@@ -71,6 +71,123 @@ int wsncmult::getCapacity() const {
 }
 
 
+/////////////////////////////////////////////////
+// Work-stealing with multiplicity over a ring //
+/////////////////////////////////////////////////
+
+wsncmultring::wsncmultring(int capacity, int numThreads) :
+    processors(numThreads),
+    tail(-1),
+    Head(0) {
+    TaskRing* r = new TaskRing{std::max(1, capacity), nullptr};
+    r->tasks = new std::atomic<int>[r->capacity];
+    std::fill(r->tasks, r->tasks + r->capacity, BOTTOM);
+    ring.store(r, relaxed);
+    head = new int[processors];
+    std::fill(head, head + numThreads, 0);
+    announced = new std::atomic<int>[processors];
+    for (int i = 0; i < processors; i++) announced[i].store(INT_MAX, relaxed);
+}
+
+wsncmultring::~wsncmultring() {
+    TaskRing* r = ring.load(relaxed);
+    delete[] r->tasks;
+    delete r;
+    for (TaskRing* old : retired) {
+        delete[] old->tasks;
+        delete old;
+    }
+    delete[] announced;
+    delete[] head;
+}
+
+int wsncmultring::lowestHead() {
+    // Head first: a thief not yet announced will read a Head at least as
+    // large as this one.
+    int lowest = Head.load();
+    for (int i = 0; i < processors; i++) {
+        lowest = std::min(lowest, announced[i].load());
+    }
+    return lowest;
+}
+
+void wsncmultring::advanceHead(int position) {
+    int h = Head.load();
+    while (h < position && !Head.compare_exchange_weak(h, position));
+}
+
+bool wsncmultring::isEmpty(int label) {
+    return head[label] > tail.load(acquire);
+}
+
+bool wsncmultring::put(int task, int label) {
+    (void) label;
+    int t = tail.load(relaxed) + 1;
+    TaskRing* r = ring.load(relaxed);
+    // Slot t still holds position t - capacity; reuse it once every label
+    // has moved past that position.
+    if (t - r->capacity >= reusable) {
+        reusable = lowestHead();
+        if (t - r->capacity >= reusable) {
+            expand();
+            r = ring.load(relaxed);
+        }
+    }
+    r->tasks[t % r->capacity].store(task, relaxed);
+    tail.store(t, release);
+    return true;
+}
+
+int wsncmultring::take(int label) {
+    head[label] = std::max(head[label], Head.load());
+    int h = head[label];
+    if (h <= tail.load(relaxed)) {
+        TaskRing* r = ring.load(relaxed);
+        int task = r->tasks[h % r->capacity].load(relaxed);
+        head[label] = h + 1;
+        advanceHead(h + 1);
+        return task;
+    }
+    return EMPTY;
+}
+
+int wsncmultring::steal(int label) {
+    announced[label].store(head[label]);
+    head[label] = std::max(head[label], Head.load());
+    int h = head[label];
+    int task = EMPTY;
+    if (h <= tail.load(acquire)) {
+        TaskRing* r = ring.load(acquire);
+        task = r->tasks[h % r->capacity].load(relaxed);
+        if (task != BOTTOM) {
+            head[label] = h + 1;
+            advanceHead(h + 1);
+        } else {
+            task = EMPTY;
+        }
+    }
+    announced[label].store(INT_MAX, release);
+    return task;
+}
+
+void wsncmultring::expand() {
+    TaskRing* r = ring.load(relaxed);
+    TaskRing* newRing = new TaskRing{2 * r->capacity, nullptr};
+    newRing->tasks = new std::atomic<int>[newRing->capacity];
+    std::fill(newRing->tasks, newRing->tasks + newRing->capacity, BOTTOM);
+    int t = tail.load(relaxed);
+    for (int p = std::max(reusable, 0); p <= t; p++) {
+        newRing->tasks[p % newRing->capacity].store(r->tasks[p % r->capacity].load(relaxed), relaxed);
+    }
+    retired.push_back(r);
+    ring.store(newRing, release);
+}
+
+int wsncmultring::getCapacity() const {
+    return ring.load(relaxed)->capacity;
+}
+
+
 ////////////////////////////////////////////////////
 // Bounded work-stealing algorithm implementation //
 ////////////////////////////////////////////////////
@@ -204,92 +321,247 @@ NodeWS* NodeWS::getNext() {
 wsncmultla::wsncmultla(int initialSize, int arrayCapacity, int numThreads) :
     arrayCapacity(arrayCapacity),
     processors(numThreads),
-    tasksLength(initialSize),
     tail(-1),
     Head(0) {
-    tasks = new NodeWS*[tasksLength];
-    tasks[0] = new NodeWS(arrayCapacity);
+    NodeDirectory* dir = new NodeDirectory{std::max(1, initialSize), nullptr};
+    dir->nodes = new NodeWS*[dir->length];
+    std::fill(dir->nodes, dir->nodes + dir->length, nullptr);
+    dir->nodes[0] = new NodeWS(arrayCapacity);
+    directory.store(dir, relaxed);
     head = new int[processors];
     std::fill(head, head + numThreads, 0);
-    currentNodes++;
-    length = currentNodes * arrayCapacity;
+    announced = new std::atomic<int>[processors];
+    for (int i = 0; i < processors; i++) announced[i].store(INT_MAX, relaxed);
+    length = arrayCapacity;
 }
 
 wsncmultla::~wsncmultla() {
     delete[] head;
-    for (int i = 0; i < currentNodes; i++) delete tasks[i];
-    delete[] tasks;
+    delete[] announced;
+    NodeDirectory* dir = directory.load(relaxed);
+    for (int n = firstNode; n <= lastNode; n++) delete dir->nodes[n % dir->length];
+    for (NodeWS* node : freeNodes) delete node;
+    delete[] dir->nodes;
+    delete dir;
+    for (NodeDirectory* old : retired) {
+        delete[] old->nodes;
+        delete old;
+    }
+}
+
+NodeWS& wsncmultla::segment(int position) {
+    NodeDirectory* dir = directory.load(acquire);
+    return *dir->nodes[(position / arrayCapacity) % dir->length];
+}
+
+void wsncmultla::advanceHead(int position) {
+    // A slow thief must not move Head back over segments already recycled.
+    int h = Head.load();
+    while (h < position && !Head.compare_exchange_weak(h, position));
 }
 
 bool wsncmultla::isEmpty(int label) {
-    return head[label] > tail;
+    return head[label] > tail.load(acquire);
 }
 
 bool wsncmultla::put(int task, int label) {
-    // std::cout << string_format("put: %d, %d", tail, label) << std::endl;
     (void) label;
-    if (tail == (length - 1)) expand();
-    tail++;
-    if (tail <= (length - 3)) {
-        (*tasks[currentNodes - 1])[(tail + 1) % arrayCapacity] = BOTTOM;
-        (*tasks[currentNodes - 1])[(tail + 2) % arrayCapacity] = BOTTOM;
-    }
-    (*tasks[currentNodes - 1])[tail % arrayCapacity] = task;
+    int t = tail.load(relaxed);
+    if (t == (length - 1)) expand();
+    t++;
+    segment(t)[t % arrayCapacity] = task;
+    tail.store(t, release);
     return true;
 }
 
 int wsncmultla::take(int label) {
-    // std::cout << string_format("take: %d, %d", head, label) << std::endl;
     head[label] = std::max(head[label], Head.load());
     int h = head[label];
-    if (h <= tail) {
-        int node = h / arrayCapacity;
-        int position = h % arrayCapacity;
-        int task = (*tasks[node])[position];
+    if (h <= tail.load(relaxed)) {
+        int task = segment(h)[h % arrayCapacity];
         head[label] = h + 1;
-        Head.store(h + 1);
+        advanceHead(h + 1);
         return task;
     }
     return EMPTY;
 }
 
 int wsncmultla::steal(int label) {
-    // std::cout << string_format("take: %d, %d", head, label) << std::endl;
+    // Announce before reading Head: either the owner sees this announcement
+    // or this thief sees a Head at least as large as the one the owner used.
+    announced[label].store(head[label]);
     head[label] = std::max(head[label], Head.load());
     int h = head[label];
-    if (h <= tail) {
-        int node = h / arrayCapacity;
-        int position = h % arrayCapacity;
-        if (node <= currentNodes) {
-            int task = (*tasks[node])[position];
-            if (task != BOTTOM) {
-                head[label] = h + 1;
-                Head.store(h + 1);
-                return task;
-            }
+    int task = EMPTY;
+    if (h <= tail.load(acquire)) {
+        task = segment(h)[h % arrayCapacity];
+        if (task != BOTTOM) {
+            head[label] = h + 1;
+            advanceHead(h + 1);
+        } else {
+            task = EMPTY;
         }
+    }
+    announced[label].store(INT_MAX, release);
+    return task;
+}
 
+void wsncmultla::recycle() {
+    int minHead = Head.load();
+    for (int i = 0; i < processors; i++) {
+        minHead = std::min(minHead, announced[i].load());
+    }
+    NodeDirectory* dir = directory.load(relaxed);
+    while (firstNode < minHead / arrayCapacity) {
+        NodeWS*& node = dir->nodes[firstNode % dir->length];
+        freeNodes.push_back(node);
+        node = nullptr;
+        firstNode++;
     }
-    return EMPTY;
 }
 
 void wsncmultla::expand() {
-    if (currentNodes < (tasksLength - 1)) {
-        tasks[currentNodes++] = new NodeWS(arrayCapacity);
-        length = currentNodes * arrayCapacity;
+    recycle();
+    NodeDirectory* dir = directory.load(relaxed);
+    if (lastNode - firstNode + 1 >= dir->length) {
+        // Only the pointers move; the old directory stays readable.
+        NodeDirectory* newDir = new NodeDirectory{dir->length * 2, nullptr};
+        newDir->nodes = new NodeWS*[newDir->length];
+        std::fill(newDir->nodes, newDir->nodes + newDir->length, nullptr);
+        for (int n = firstNode; n <= lastNode; n++) {
+            newDir->nodes[n % newDir->length] = dir->nodes[n % dir->length];
+        }
+        retired.push_back(dir);
+        dir = newDir;
+        directory.store(dir, release);
+    }
+    NodeWS* node;
+    if (freeNodes.empty()) {
+        node = new NodeWS(arrayCapacity);
     } else {
+        node = freeNodes.back();
+        freeNodes.pop_back();
+    }
+    lastNode++;
+    dir->nodes[lastNode % dir->length] = node;
+    length = (lastNode + 1) * arrayCapacity;
+}
+
+int wsncmultla::getCapacity() const {
+    return (lastNode - firstNode + 1) * arrayCapacity;
+}
+
+// //////////////////////////////////////////////
+// // Bounded work-stealing linked-list based  //
+// //////////////////////////////////////////////
+
+BNodeWS::BNodeWS(int capacity) : capacity(capacity) {
+    array = new std::atomic<int>[capacity];
+    B = new std::atomic<bool>[capacity];
+    for (int i = 0; i < capacity; i++) {
+        array[i].store(BOTTOM, relaxed);
+        B[i].store(true, relaxed);
+    }
+}
+
+BNodeWS::~BNodeWS() {
+    delete[] array;
+    delete[] B;
+}
+
+std::atomic<int>& BNodeWS::operator[](int i) {
+    return array[i];
+}
+
+std::atomic<bool>& BNodeWS::flag(int i) {
+    return B[i];
+}
+
+bwsncmultla::bwsncmultla(int initialSize, int arrayCapacity, int numThreads) :
+    arrayCapacity(arrayCapacity),
+    processors(numThreads),
+    tasksLength(std::max(1, initialSize)),
+    tail(-1),
+    Head(0) {
+    BNodeWS** nodes = new BNodeWS*[tasksLength];
+    std::fill(nodes, nodes + tasksLength, nullptr);
+    nodes[0] = new BNodeWS(arrayCapacity);
+    tasks.store(nodes, relaxed);
+    head = new int[processors];
+    std::fill(head, head + numThreads, 0);
+    currentNodes++;
+    length = currentNodes * arrayCapacity;
+}
+
+bwsncmultla::~bwsncmultla() {
+    delete[] head;
+    BNodeWS** nodes = tasks.load(relaxed);
+    for (int i = 0; i < currentNodes; i++) delete nodes[i];
+    delete[] nodes;
+    for (BNodeWS** old : retired) delete[] old;
+}
+
+bool bwsncmultla::isEmpty(int label) {
+    (void) label;
+    return Head.load() > tail.load(acquire);
+}
+
+bool bwsncmultla::put(int task, int label) {
+    (void) label;
+    int t = tail.load(relaxed);
+    if (t == (length - 1)) expand();
+    t++;
+    (*tasks.load(relaxed)[t / arrayCapacity])[t % arrayCapacity].store(task, relaxed);
+    tail.store(t, release);
+    return true;
+}
+
+int bwsncmultla::take(int label) {
+    head[label] = std::max(head[label], Head.load());
+    int h = head[label];
+    if (h <= tail.load(relaxed)) {
+        int task = (*tasks.load(relaxed)[h / arrayCapacity])[h % arrayCapacity].load(relaxed);
+        head[label] = h + 1;
+        Head.store(h + 1);
+        return task;
+    }
+    return EMPTY;
+}
+
+int bwsncmultla::steal(int label) {
+    while (true) {
+        head[label] = std::max(head[label], Head.load());
+        int h = head[label];
+        if (h > tail.load(acquire)) return EMPTY;
+        BNodeWS& node = *tasks.load(acquire)[h / arrayCapacity];
+        int task = node[h % arrayCapacity].load(relaxed);
+        if (task != BOTTOM) {
+            head[label] = h + 1;
+            if (node.flag(h % arrayCapacity).exchange(false)) {
+                Head.store(h + 1);
+                return task;
+            }
+        }
+    }
+}
+
+void bwsncmultla::expand() {
+    BNodeWS** nodes = tasks.load(relaxed);
+    if (currentNodes == tasksLength) {
+        // Only the pointers are copied; segments stay where they are.
         int newLength = tasksLength * 2;
-        NodeWS** newNodes = new NodeWS*[newLength];
-        for(int i = 0; i < tasksLength; i++) newNodes[i] = tasks[i];
-        newNodes[currentNodes++] = new NodeWS(arrayCapacity);
-        NodeWS** tmp = tasks;
-        tasks = newNodes;
-        delete[] tmp;
+        BNodeWS** newNodes = new BNodeWS*[newLength];
+        std::copy(nodes, nodes + tasksLength, newNodes);
+        std::fill(newNodes + tasksLength, newNodes + newLength, nullptr);
+        retired.push_back(nodes);
+        nodes = newNodes;
         tasksLength = newLength;
-        length = currentNodes * arrayCapacity;
     }
+    nodes[currentNodes++] = new BNodeWS(arrayCapacity);
+    tasks.store(nodes, release);
+    length = currentNodes * arrayCapacity;
 }
 
-int wsncmultla::getCapacity() const {
+int bwsncmultla::getCapacity() const {
     return length;
 }
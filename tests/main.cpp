@@ -2,6 +2,8 @@
 #include <list>
 #include <vector>
 #include "ws/lib.hpp"
+#include "ws/scheduler.hpp"
+#include "ws/task.hpp"
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
@@ -506,6 +508,37 @@ TEST_F(TaskArrayTest, testGet) {
     EXPECT_EQ(10101, array.get(0));
 }
 
+// The owner takes and the other threads steal until the numTasks tasks put
+// by the owner are gone; true when each one came out exactly once.
+bool tasksHandedOutOnce(AlgorithmType algType, int numTasks, int numThreads)
+{
+    std::unique_ptr<workStealingAlgorithm> ws(workStealingAlgorithmFactory(algType, numTasks, numThreads));
+    for (int i = 0; i < numTasks; i++) ws->put(i);
+    std::unique_ptr<std::atomic<int>[]> seen(new std::atomic<int>[numTasks]());
+    std::atomic<int> taken = 0;
+    std::vector<std::thread> threads;
+    for (int id = 0; id < numThreads; id++) {
+        threads.emplace_back([&, id]() {
+            while (taken.load() < numTasks) {
+                int task = id == 0 ? ws->take() : ws->steal();
+                if (task >= 0) {
+                    seen[task]++;
+                    taken++;
+                } else if (id == 0 && task == EMPTY) {
+                    break;
+                }
+                // Thieves retry after EMPTY or ABORT
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    if (taken.load() != numTasks) return false;
+    for (int i = 0; i < numTasks; i++) {
+        if (seen[i].load() != 1) return false;
+    }
+    return true;
+}
+
 ////////////////////////////////////////////////////
 // Test for the Chase-Lev work-stealing algorithm //
 ////////////////////////////////////////////////////
@@ -572,6 +605,46 @@ TEST_F(chaselevTest, test_resize) {
     EXPECT_EQ(80, ws.getSize());
 }
 
+template <typename Deque>
+void expectDeltaLeftToOwner()
+{
+    Deque ws(64, 4);
+    for (int i = 0; i < 6; i++) ws.put(i);
+    // Thieves stop while 4 tasks remain
+    EXPECT_EQ(0, ws.steal());
+    EXPECT_EQ(1, ws.steal());
+    EXPECT_EQ(EMPTY, ws.steal());
+    EXPECT_FALSE(ws.isEmpty());
+    for (int i = 5; i >= 2; i--) EXPECT_EQ(i, ws.take());
+    EXPECT_EQ(EMPTY, ws.take());
+    EXPECT_TRUE(ws.isEmpty());
+}
+
+TEST_F(chaselevTest, fenceFreeLeavesDeltaToOwner) {
+    expectDeltaLeftToOwner<chaselevFenceFree>();
+    expectDeltaLeftToOwner<cilkFenceFree>();
+    for (AlgorithmType algType : {AlgorithmType::CHASELEV, AlgorithmType::CHASELEV_FENCE_FREE,
+                                  AlgorithmType::CILK_FENCE_FREE}) {
+        EXPECT_TRUE(tasksHandedOutOnce(algType, 20000, 4)) << getAlgorithmTypeFromEnum(algType);
+    }
+}
+
+TEST_F(chaselevTest, membarrierHandsOutTasksOnce) {
+    // Both with membarrier and with the fallback fences
+    RecordProperty("membarrier", membarrierAvailable() ? "available" : "fallback fences");
+    for (AlgorithmType algType : {AlgorithmType::CHASELEV_MEMBARRIER, AlgorithmType::CILK_MEMBARRIER}) {
+        EXPECT_TRUE(tasksHandedOutOnce(algType, 20000, 4)) << getAlgorithmTypeFromEnum(algType);
+        EXPECT_EQ(algType, getAlgorithmTypeFromString(getAlgorithmTypeFromEnum(algType)));
+    }
+    chaselevMembarrier ws(10);
+    for (int i = 0; i < 3; i++) ws.put(i);
+    EXPECT_EQ(0, ws.steal());
+    EXPECT_EQ(2, ws.take());
+    EXPECT_EQ(1, ws.take());
+    EXPECT_EQ(EMPTY, ws.take());
+    EXPECT_EQ(EMPTY, ws.steal());
+}
+
 ///////////////////////////////////////////////////
 // Test for the cilk THE work-stealing algorithm //
 ///////////////////////////////////////////////////
@@ -639,6 +712,55 @@ TEST_F(cilkTest, test_resize) {
     EXPECT_EQ(80, ws.getSize());
 }
 
+template <typename Lock>
+int countUnderLock(int numThreads, int increments)
+{
+    Lock lock;
+    int counter = 0;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; i++) {
+        threads.emplace_back([&]() {
+            for (int k = 0; k < increments; k++) {
+                // Half of the increments through try_lock
+                if (k % 2 == 0) {
+                    while (!lock.try_lock()) cpuRelax();
+                    counter++;
+                    lock.unlock();
+                } else {
+                    const std::lock_guard<Lock> guard(lock);
+                    counter++;
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    return counter;
+}
+
+TEST_F(cilkTest, locksExcludeEachOther) {
+    EXPECT_EQ(4 * 20000, countUnderLock<ttasLock>(4, 20000));
+    EXPECT_EQ(4 * 20000, countUnderLock<ticketLock>(4, 20000));
+    EXPECT_EQ(4 * 20000, countUnderLock<mcsLock>(4, 20000));
+    ticketLock ticket;
+    ticket.lock();
+    EXPECT_FALSE(ticket.try_lock());
+    ticket.unlock();
+    EXPECT_TRUE(ticket.try_lock());
+    ticket.unlock();
+    mcsLock mcs;
+    EXPECT_TRUE(mcs.try_lock());
+    EXPECT_FALSE(mcs.try_lock());
+    mcs.unlock();
+}
+
+TEST_F(cilkTest, everyLockHandsOutTasksOnce) {
+    for (AlgorithmType algType : {AlgorithmType::CILK, AlgorithmType::CILK_TTAS,
+                                  AlgorithmType::CILK_TICKET, AlgorithmType::CILK_MCS}) {
+        EXPECT_TRUE(tasksHandedOutOnce(algType, 20000, 4)) << getAlgorithmTypeFromEnum(algType);
+        EXPECT_EQ(algType, getAlgorithmTypeFromString(getAlgorithmTypeFromEnum(algType)));
+    }
+}
+
 ///////////////////////////////////////////////////////////
 // Test for the idempotent FIFO work-stealing algorithms //
 ///////////////////////////////////////////////////////////
@@ -1085,6 +1207,157 @@ TEST_F(wsncmultlaTest, test_resize) {
     EXPECT_EQ(50, ws.getCapacity());
 }
 
+TEST_F(wsncmultlaTest, testRecycling) {
+    wsncmultla ws(1, 10, 2);
+    for (int i = 0; i < 10000; i++) {
+        ws.put(i, 0);
+        EXPECT_EQ(i, ws.take(0));
+    }
+    EXPECT_LE(ws.getCapacity(), 20);
+    ws.put(10000, 0);
+    EXPECT_EQ(10000, ws.steal(1));
+    EXPECT_EQ(EMPTY, ws.steal(1));
+}
+
+TEST_F(wsncmultlaTest, testRecyclingConcurrentSteals) {
+    const int numThieves = 3;
+    const int numTasks = 20000;
+    wsncmultla ws(1, 16, numThieves + 1);
+    std::vector<std::atomic<int>> seen(numTasks);
+    for (auto& s : seen) s = 0;
+    std::atomic<bool> done(false);
+    std::vector<std::thread> thieves;
+    for (int i = 0; i < numThieves; i++) {
+        thieves.emplace_back([&, i]() {
+            while (true) {
+                bool finished = done.load();
+                int task = ws.steal(i + 1);
+                if (task >= 0) seen[task]++;
+                else if (finished) break;
+            }
+        });
+    }
+    for (int i = 0; i < numTasks; i++) {
+        ws.put(i, 0);
+        if (i % 3 == 0) {
+            int task = ws.take(0);
+            if (task >= 0) seen[task]++;
+        }
+    }
+    done = true;
+    for (auto& t : thieves) t.join();
+    int task;
+    while ((task = ws.take(0)) >= 0) seen[task]++;
+    for (int i = 0; i < numTasks; i++) {
+        EXPECT_LE(1, seen[i].load());
+    }
+}
+
+class wsncmultringTest : public ::testing::Test {
+protected:
+    wsncmultringTest() {}
+
+    ~wsncmultringTest() {}
+
+    void SetUp() {}
+
+    void TearDown() {}
+};
+
+TEST_F(wsncmultringTest, testIsEmpty) {
+    wsncmultring ws(10, 1);
+    EXPECT_EQ(true, ws.isEmpty(0));
+    wsncmultring ws1(10, 2);
+    EXPECT_EQ(true, ws1.isEmpty(0));
+    ws1.put(10, 1);
+    EXPECT_EQ(false, ws1.isEmpty(0));
+    EXPECT_EQ(false, ws1.isEmpty(1));
+}
+
+TEST_F(wsncmultringTest, testFIFO_take) {
+    wsncmultring ws(10, 1);
+    for (int i = 0; i < 1000; i++) {
+        bool inserted = ws.put(i, 0);
+        EXPECT_TRUE(inserted);
+    }
+    for (int i = 0; i < 1000; i++) {
+        int output = ws.take(0);
+        EXPECT_EQ(i, output);
+    }
+}
+
+TEST_F(wsncmultringTest, testFIFO_steal) {
+    wsncmultring ws(10, 1);
+    for (int i = 0; i < 1000; i++) {
+        bool inserted = ws.put(i, 0);
+        EXPECT_TRUE(inserted);
+    }
+    for (int i = 0; i < 1000; i++) {
+        int output = ws.steal(0);
+        EXPECT_EQ(i, output);
+    }
+    EXPECT_EQ(EMPTY, ws.steal(0));
+}
+
+TEST_F(wsncmultringTest, test_resize) {
+    wsncmultring ws(10, 1);
+    for (int i = 0; i < 10; i++) ws.put(i, 0);
+    EXPECT_EQ(10, ws.getCapacity());
+    for (int i = 0; i < 10; i++) ws.put(i, 0);
+    EXPECT_EQ(20, ws.getCapacity());
+    for (int i = 0; i < 10; i++) ws.put(i, 0);
+    EXPECT_EQ(40, ws.getCapacity());
+}
+
+TEST_F(wsncmultringTest, testWrapAround) {
+    wsncmultring ws(10, 2);
+    for (int i = 0; i < 10000; i++) {
+        ws.put(i, 0);
+        ws.put(i, 0);
+        EXPECT_EQ(i, ws.take(0));
+        EXPECT_EQ(i, ws.steal(1));
+    }
+    EXPECT_EQ(10, ws.getCapacity());
+    // A live window larger than the ring forces it to grow, keeping order
+    for (int i = 0; i < 15; i++) ws.put(i, 0);
+    EXPECT_EQ(20, ws.getCapacity());
+    for (int i = 0; i < 15; i++) EXPECT_EQ(i, ws.take(0));
+}
+
+TEST_F(wsncmultringTest, testConcurrentSteals) {
+    const int numThieves = 3;
+    const int numTasks = 20000;
+    wsncmultring ws(16, numThieves + 1);
+    std::vector<std::atomic<int>> seen(numTasks);
+    for (auto& s : seen) s = 0;
+    std::atomic<bool> done(false);
+    std::vector<std::thread> thieves;
+    for (int i = 0; i < numThieves; i++) {
+        thieves.emplace_back([&, i]() {
+            while (true) {
+                bool finished = done.load();
+                int task = ws.steal(i + 1);
+                if (task >= 0) seen[task]++;
+                else if (finished) break;
+            }
+        });
+    }
+    for (int i = 0; i < numTasks; i++) {
+        ws.put(i, 0);
+        if (i % 3 == 0) {
+            int task = ws.take(0);
+            if (task >= 0) seen[task]++;
+        }
+    }
+    done = true;
+    for (auto& t : thieves) t.join();
+    int task;
+    while ((task = ws.take(0)) >= 0) seen[task]++;
+    for (int i = 0; i < numTasks; i++) {
+        EXPECT_LE(1, seen[i].load());
+    }
+}
+
 /////////////////////////////////////////////
 // Bounded work-stealing with multiplicity //
 /////////////////////////////////////////////
@@ -1152,6 +1425,96 @@ TEST_F(bwsncmultTest, test_resize) {
     EXPECT_EQ(40, ws.getCapacity());
 }
 
+class bwsncmultlaTest : public ::testing::Test {
+protected:
+    bwsncmultlaTest() {}
+
+    ~bwsncmultlaTest() {}
+
+    void SetUp() {}
+
+    void TearDown() {}
+};
+
+TEST_F(bwsncmultlaTest, testIsEmpty) {
+    bwsncmultla ws(1, 10, 1);
+    EXPECT_EQ(true, ws.isEmpty(0));
+    bwsncmultla ws1(1, 10, 2);
+    EXPECT_EQ(true, ws1.isEmpty(0));
+    ws1.put(10, 1);
+    EXPECT_EQ(false, ws1.isEmpty(0));
+    EXPECT_EQ(false, ws1.isEmpty(1));
+}
+
+TEST_F(bwsncmultlaTest, testNotEmpty) {
+    bwsncmultla ws(1, 10, 4);
+    ws.put(10, 3);
+    EXPECT_EQ(false, ws.isEmpty(3));
+}
+
+TEST_F(bwsncmultlaTest, testFIFO_take) {
+    bwsncmultla ws(1, 10, 1);
+    for (int i = 0; i < 1000; i++) {
+        bool inserted = ws.put(i, 0);
+        EXPECT_TRUE(inserted);
+    }
+    for (int i = 0; i < 1000; i++) {
+        int output = ws.take(0);
+        EXPECT_EQ(i, output);
+    }
+}
+
+TEST_F(bwsncmultlaTest, testFIFO_steal) {
+    bwsncmultla ws(1, 10, 1);
+    for (int i = 0; i < 1000; i++) {
+        bool inserted = ws.put(i, 0);
+        EXPECT_TRUE(inserted);
+    }
+    for (int i = 0; i < 1000; i++) {
+        int output = ws.steal(0);
+        EXPECT_EQ(i, output);
+    }
+    EXPECT_EQ(EMPTY, ws.steal(0));
+}
+
+TEST_F(bwsncmultlaTest, test_resize) {
+    bwsncmultla ws(1, 10, 1);
+    for (int i = 0; i < 10; i++) ws.put(i, 0);
+    EXPECT_EQ(10, ws.getCapacity());
+    for (int i = 0; i < 10; i++) ws.put(i, 0);
+    EXPECT_EQ(20, ws.getCapacity());
+    for (int i = 0; i < 10; i++) ws.put(i, 0);
+    EXPECT_EQ(30, ws.getCapacity());
+    for (int i = 0; i < 20; i++) ws.put(i, 0);
+    EXPECT_EQ(50, ws.getCapacity());
+}
+
+TEST_F(bwsncmultlaTest, testStealAtMostOnce) {
+    const int numThieves = 4;
+    const int numTasks = 10000;
+    bwsncmultla ws(1, 64, numThieves + 1);
+    std::vector<std::atomic<int>> stolen(numTasks);
+    for (auto& s : stolen) s = 0;
+    std::vector<std::thread> thieves;
+    std::atomic<bool> done(false);
+    for (int i = 0; i < numThieves; i++) {
+        thieves.emplace_back([&, i]() {
+            while (true) {
+                bool finished = done.load();
+                int task = ws.steal(i + 1);
+                if (task >= 0) stolen[task]++;
+                else if (finished) break;
+            }
+        });
+    }
+    for (int i = 0; i < numTasks; i++) ws.put(i, 0);
+    done = true;
+    for (auto& t : thieves) t.join();
+    for (int i = 0; i < numTasks; i++) {
+        EXPECT_EQ(1, stolen[i].load());
+    }
+}
+
 class STTest : public ::testing::Test {
 protected:
     STTest() {}
@@ -1346,6 +1709,384 @@ TEST_F(STTest, spanningTreeBWSNCTest)
 
 
 
+TEST_F(STTest, spanningTreeBWSNCLATest)
+{
+    const int numProcessors = std::thread::hardware_concurrency();
+    ws::Params p{GraphType::TORUS_2D, 100, false,
+        numProcessors, AlgorithmType::B_WS_NC_MULT_LA_OPT,
+        10000, 1, StepSpanningTreeType::COUNTER, false,
+        false, false, true};
+    graph g = torus2D(100);
+    int* processors = new int[numProcessors];
+    Report r{numProcessors, processors};
+    int* roots = stubSpanning(g, numProcessors);
+    graph result = spanningTree(g, roots, r, p);
+    GraphCycleType type = detectCycleType(result);
+    std::cout << (r.executionTime) << "ns" << std::endl;
+    experiment(p, g);
+    EXPECT_EQ(GraphCycleType::TREE, type);
+    delete[] processors;
+    delete[] roots;
+}
+
+TEST_F(STTest, spanningTreeWSNCRingTest)
+{
+    const int numProcessors = std::thread::hardware_concurrency();
+    ws::Params p{GraphType::TORUS_2D, 100, false,
+        numProcessors, AlgorithmType::WS_NC_MULT_RING_OPT,
+        10000, 1, StepSpanningTreeType::COUNTER, false,
+        false, false, true};
+    graph g = torus2D(100);
+    int* processors = new int[numProcessors];
+    Report r{numProcessors, processors};
+    int* roots = stubSpanning(g, numProcessors);
+    graph result = spanningTree(g, roots, r, p);
+    GraphCycleType type = detectCycleType(result);
+    std::cout << (r.executionTime) << "ns" << std::endl;
+    experiment(p, g);
+    EXPECT_EQ(GraphCycleType::TREE, type);
+    delete[] processors;
+    delete[] roots;
+}
+
+// Vertices reachable from roots following the stored edges.
+int reachableFrom(graph& g, int* roots, int numRoots)
+{
+    std::vector<bool> seen(g.getNumberVertices(), false);
+    std::vector<int> stack(roots, roots + numRoots);
+    int reached = 0;
+    for (int i = 0; i < numRoots; i++) seen[roots[i]] = true;
+    while (!stack.empty()) {
+        int v = stack.back();
+        stack.pop_back();
+        reached++;
+        for (int w : g.getNeighbours(v)) {
+            if (!seen[w]) { seen[w] = true; stack.emplace_back(w); }
+        }
+    }
+    return reached;
+}
+
+TEST_F(STTest, spanningTreeStopsWhenRootsCannotReachAll)
+{
+    // A directed path over half of the vertices, the rest isolated
+    graph g(true, 0, 100, GraphType::RANDOM);
+    for (int v = 0; v < 49; v++) g.addEdge(v, v + 1);
+    for (AlgorithmType algType : {AlgorithmType::CHASELEV, AlgorithmType::IDEMPOTENT_LIFO,
+                                  AlgorithmType::WS_NC_MULT_OPT}) {
+        ws::Params p{GraphType::RANDOM, 100, false, 4, algType,
+            1024, 1, StepSpanningTreeType::COUNTER, true,
+            false, false, isSpecial(algType)};
+        int* processors = new int[4];
+        Report r{4, processors};
+        int roots[] = {0, 10, 20, 30};
+        graph result = spanningTree(g, roots, r, p);
+        int reached = 0;
+        for (int i = 0; i < 4; i++) reached += r.processors_[i];
+        EXPECT_EQ(50, reached) << getAlgorithmTypeFromEnum(algType);
+        EXPECT_EQ(GraphCycleType::DISCONNECTED, detectCycleType(result));
+        delete[] processors;
+    }
+}
+
+TEST_F(STTest, spanningTreeDirectedTorus60Test)
+{
+    graph g = directedTorus2D60(60);
+    for (AlgorithmType algType : {AlgorithmType::CHASELEV, AlgorithmType::B_WS_NC_MULT_OPT}) {
+        ws::Params p{GraphType::TORUS_2D_60, 60, false, 4, algType,
+            4096, 1, StepSpanningTreeType::COUNTER, true,
+            false, false, isSpecial(algType)};
+        int* processors = new int[4];
+        Report r{4, processors};
+        int* roots = stubSpanning(g, 4);
+        graph result = spanningTree(g, roots, r, p);
+        int reached = 0;
+        for (int i = 0; i < 4; i++) reached += r.processors_[i];
+        EXPECT_EQ(reachableFrom(g, roots, 4), reached) << getAlgorithmTypeFromEnum(algType);
+        EXPECT_NE(GraphCycleType::CYCLE, detectCycleType(result));
+        json j = experiment(p, g);
+        EXPECT_EQ(reached, j["reached"].get<int>());
+        delete[] processors;
+        delete[] roots;
+    }
+}
+
+TEST_F(STTest, compactVertexState)
+{
+    colorArray narrow(10, 4);
+    colorArray wide(10, 300);
+    narrow.store(3, 4);
+    wide.store(3, 300);
+    EXPECT_EQ(4, narrow.load(3));
+    EXPECT_EQ(300, wide.load(3));
+    EXPECT_EQ(10u, narrow.bytes());
+    EXPECT_EQ(20u, wide.bytes());
+    atomicBitmap visited(130);
+    for (int i = 0; i < visited.numWords(); i++) visited.clearWord(i);
+    EXPECT_EQ(3, visited.numWords());
+    EXPECT_TRUE(visited.testAndSet(129));
+    EXPECT_FALSE(visited.testAndSet(129));
+    EXPECT_TRUE(visited.test(129));
+    EXPECT_FALSE(visited.test(128));
+
+    graph g = torus2D(100);
+    ws::Params p{GraphType::TORUS_2D, 100, false, 4, AlgorithmType::CHASELEV,
+        10000, 1, StepSpanningTreeType::COUNTER, false, false, false, false};
+    json result = experiment(p, g);
+    // Three atomic<int> per vertex before
+    long long before = 3LL * g.getNumberVertices() * sizeof(std::atomic<int>);
+    EXPECT_GE(before, 2 * result["stateBytes"].get<long long>());
+    EXPECT_EQ(g.getNumberVertices(), result["reached"].get<int>());
+}
+
+TEST_F(STTest, claimOnceExpandsEachVertexOnce)
+{
+    graph g = torus2D(50);
+    for (int at = AlgorithmType::CHASELEV; at != AlgorithmType::LAST; at++) {
+        AlgorithmType algType = static_cast<AlgorithmType>(at);
+        ws::Params p{GraphType::TORUS_2D, 50, false, 4, algType,
+            4096, 1, StepSpanningTreeType::COUNTER, false, false, false, isSpecial(algType)};
+        json once = experiment(p, g);
+        EXPECT_EQ(g.getNumberVertices(), once["reached"].get<int>());
+        EXPECT_GE(g.getNumberVertices(), once["expansions"].get<int>()) << getAlgorithmTypeFromEnum(algType);
+        // Not checked at all for the deques that hand out each task once
+        if (handsOutOnce(algType)) {
+            EXPECT_EQ(0, once["duplicates"].get<int>());
+        }
+        p.claimOnce = false;
+        json racy = experiment(p, g);
+        EXPECT_EQ(g.getNumberVertices(), racy["reached"].get<int>());
+        EXPECT_LE(0, racy["duplicates"].get<int>());
+        EXPECT_FALSE(racy["params"]["claimOnce"].get<bool>());
+    }
+}
+
+TEST_F(STTest, handsOutOnceOnlyForExactlyOnceDeques)
+{
+    EXPECT_TRUE(handsOutOnce(AlgorithmType::CHASELEV));
+    EXPECT_TRUE(handsOutOnce(AlgorithmType::CILK_MCS));
+    EXPECT_TRUE(handsOutOnce(AlgorithmType::CHASELEV_MEMBARRIER));
+    EXPECT_FALSE(handsOutOnce(AlgorithmType::IDEMPOTENT_FIFO));
+    EXPECT_FALSE(handsOutOnce(AlgorithmType::IDEMPOTENT_LIFO));
+    EXPECT_FALSE(handsOutOnce(AlgorithmType::WS_NC_MULT_RING_OPT));
+    EXPECT_FALSE(handsOutOnce(AlgorithmType::B_WS_NC_MULT_LA_OPT));
+}
+
+TEST_F(STTest, adjacencyArrayMatchesLists)
+{
+    graph g = directedTorus3D40(6);
+    adjacencyArray adjacency(g);
+    for (int v = 0; v < g.getNumberVertices(); v++) {
+        std::list<int>& neighbours = g.getNeighbours(v);
+        ASSERT_EQ((int)neighbours.size(), adjacency.degree(v));
+        EXPECT_TRUE(std::equal(neighbours.begin(), neighbours.end(), adjacency.begin(v)));
+    }
+}
+
+TEST_F(STTest, prefetchingTraversalsBuildTrees)
+{
+    graph g = torus3D(14);
+    for (AlgorithmType algType : {AlgorithmType::CHASELEV, AlgorithmType::IDEMPOTENT_FIFO,
+                                  AlgorithmType::WS_NC_MULT_OPT}) {
+        for (bool contiguous : {false, true}) {
+            for (int distance : {0, 1, 16}) {
+                ws::Params p{GraphType::TORUS_3D, 14, false, 4, algType,
+                    4096, 1, StepSpanningTreeType::COUNTER, false, false, false, isSpecial(algType)};
+                p.contiguousAdjacency = contiguous;
+                p.prefetchDistance = distance;
+                p.taskBatch = contiguous ? 1000 : 4; // Clamped to maxTaskBatch
+                json result = experiment(p, g);
+                EXPECT_EQ(g.getNumberVertices(), result["reached"].get<int>());
+                // Batched vertices are still expanded once
+                EXPECT_GE(g.getNumberVertices(), result["expansions"].get<int>())
+                    << getAlgorithmTypeFromEnum(algType) << contiguous << distance;
+            }
+        }
+    }
+}
+
+TEST_F(STTest, simdKernelsAgree)
+{
+    std::mt19937 rng(7);
+    for (int numThreads : {8, 300}) {
+        const int n = 1001;
+        colorArray colors(n, numThreads);
+        for (int v = 0; v < n; v++) colors.store(v, rng() % 3 == 0 ? 0 : 1 + rng() % numThreads);
+        for (int length : {0, 1, 4, 6, 8, 15, 16, 17, 64}) {
+            std::vector<int> neighbours(length);
+            for (int& w : neighbours) w = rng() % n;
+            if (length > 0) neighbours.back() = n - 1; // Reads past the last color
+            int expected[64], found[64];
+            int count = unvisitedNeighbours(colors, neighbours.data(), length, expected, SimdKernel::SCALAR_KERNEL);
+            for (SimdKernel kernel : {SimdKernel::AVX2_KERNEL, SimdKernel::AVX512_KERNEL}) {
+                if (!simdKernelSupported(kernel)) continue;
+                ASSERT_EQ(count, unvisitedNeighbours(colors, neighbours.data(), length, found, kernel))
+                    << getSimdKernelName(kernel) << " " << length;
+                EXPECT_TRUE(std::equal(expected, expected + count, found)) << getSimdKernelName(kernel);
+            }
+        }
+    }
+    EXPECT_TRUE(simdKernelSupported(bestSimdKernel()));
+}
+
+TEST_F(STTest, simdFilteredTraversal)
+{
+    graph g = directedTorus2D(40);
+    ws::Params p{GraphType::TORUS_2D, 40, true, 4, AlgorithmType::CHASELEV,
+        4096, 1, StepSpanningTreeType::COUNTER, false, false, false, false};
+    p.contiguousAdjacency = true;
+    json result = experiment(p, g);
+    EXPECT_EQ(g.getNumberVertices(), result["reached"].get<int>());
+    EXPECT_EQ(getSimdKernelName(bestSimdKernel()), result["simdKernel"].get<std::string>());
+}
+
+TEST_F(STTest, batchedCounterTerminates)
+{
+    graph g = torus2D(40);
+    for (int batch : {1, 7, 100000}) {
+        for (AlgorithmType algType : {AlgorithmType::CHASELEV, AlgorithmType::WS_NC_MULT_OPT}) {
+            ws::Params p{GraphType::TORUS_2D, 40, false, 4, algType,
+                4096, 1, StepSpanningTreeType::COUNTER, false, false, false, isSpecial(algType)};
+            p.counterBatch = batch;
+            int* processors = new int[4];
+            Report r{4, processors};
+            int* roots = stubSpanning(g, 4);
+            graph result = spanningTree(g, roots, r, p);
+            EXPECT_EQ(GraphCycleType::TREE, detectCycleType(result)) << batch;
+            delete[] processors;
+            delete[] roots;
+        }
+    }
+}
+
+TEST_F(STTest, spanningTreeSimpleTest)
+{
+    ws::Params p{GraphType::TORUS_2D, 100, false,
+        1, AlgorithmType::SIMPLE,
+        10000, 1, StepSpanningTreeType::COUNTER, false,
+        false, false, false};
+    graph g = torus2D(100);
+    int* processors = new int[1];
+    Report r{1, processors};
+    int* roots = stubSpanning(g, 1);
+    graph result = spanningTree(g, roots, r, p);
+    EXPECT_EQ(GraphCycleType::TREE, detectCycleType(result));
+    EXPECT_EQ(g.getNumberVertices(), r.expansions.load());
+    EXPECT_EQ(g.getNumberVertices(), r.puts.load());
+    delete[] processors;
+    delete[] roots;
+}
+
+TEST_F(STTest, zeroCostBaselineMetrics)
+{
+    graph g = torus2D(50);
+    ws::Params p{GraphType::TORUS_2D, 50, false,
+        1, AlgorithmType::CHASELEV,
+        10000, 2, StepSpanningTreeType::COUNTER, false,
+        false, false, false, 0, true};
+    json baseline = baselineStatistics(p, g);
+    EXPECT_EQ("SIMPLE", baseline["algorithm"]);
+    json zero = experimentStatistics(p, g);
+    EXPECT_EQ(0, zero["steals"]["max"].get<int>());
+    addBaselineMetrics(zero, baseline);
+    EXPECT_GT(zero["overhead"].get<double>(), 0.0);
+    p.zeroCost = false;
+    json result = experimentStatistics(p, g);
+    addBaselineMetrics(result, baseline);
+    EXPECT_DOUBLE_EQ(1.0, result["workInflation"].get<double>());
+    EXPECT_GT(result["speedup"].get<double>(), 0.0);
+}
+
+TEST_F(STTest, hardwareCounters)
+{
+    perfCounters counters;
+    counters.start();
+    counters.stop();
+    for (int e = 0; e < PerfEvent::NUM_PERF_EVENTS; e++) {
+        EXPECT_GE(counters.get(static_cast<PerfEvent>(e)), -1);
+    }
+    graph g = torus2D(30);
+    ws::Params p{GraphType::TORUS_2D, 30, false,
+        2, AlgorithmType::CHASELEV,
+        10000, 1, StepSpanningTreeType::COUNTER, false,
+        false, false, false, 0, false, true};
+    json result = experiment(p, g);
+    ASSERT_TRUE(result.contains("perf"));
+    EXPECT_EQ(2, (int)result["perf"]["workers"].size());
+    EXPECT_EQ(counters.isAvailable(), result["perf"]["available"].get<bool>());
+    ASSERT_TRUE(result["perf"].contains("scaling"));
+    for (int e = 0; e < PerfEvent::NUM_PERF_EVENTS; e++) {
+        std::string name = getPerfEventName(static_cast<PerfEvent>(e));
+        if (result["perf"][name].is_null()) {
+            EXPECT_TRUE(result["perf"]["scaling"][name].is_null());
+        } else {
+            EXPECT_GE(result["perf"]["scaling"][name].get<double>(), 1.0);
+        }
+    }
+}
+
+TEST_F(STTest, perfScalingFactor)
+{
+    // One worker with a multiplexed event (counted half of the time) and an
+    // unavailable one; the rest counted the whole time.
+    const int n = PerfEvent::NUM_PERF_EVENTS;
+    std::vector<long long> worker(3 * n, 0);
+    for (int e = 0; e < n; e++) {
+        worker[e] = 10;
+        worker[n + e] = 1000;
+        worker[2 * n + e] = 1000;
+    }
+    worker[PerfEvent::CYCLES] = 200;
+    worker[2 * n + PerfEvent::CYCLES] = 500;
+    worker[PerfEvent::LLC_MISSES] = -1;
+    json result = perfToJson({worker, worker});
+    EXPECT_EQ(400, result[getPerfEventName(PerfEvent::CYCLES)].get<long long>());
+    EXPECT_DOUBLE_EQ(2.0, result["scaling"][getPerfEventName(PerfEvent::CYCLES)].get<double>());
+    EXPECT_DOUBLE_EQ(1.0, result["scaling"][getPerfEventName(PerfEvent::INSTRUCTIONS)].get<double>());
+    EXPECT_TRUE(result["scaling"][getPerfEventName(PerfEvent::LLC_MISSES)].is_null());
+    EXPECT_DOUBLE_EQ(2.0, result["workers"][0]["scaling"][getPerfEventName(PerfEvent::CYCLES)].get<double>());
+}
+
+TEST_F(STTest, traceRingBuffer)
+{
+    tracer t(1, 4);
+    traceBuffer* buffer = t.worker(0);
+    for (int i = 0; i < 6; i++) buffer->record(TraceEventType::TRACE_PUT, i);
+    std::vector<traceEvent> events = buffer->snapshot();
+    ASSERT_EQ(4, (int)events.size());
+    EXPECT_EQ(2, events[0].value);
+    EXPECT_EQ(5, events[3].value);
+    EXPECT_EQ(2, (int)buffer->dropped());
+    EXPECT_LE(events[0].timestamp, events[3].timestamp);
+}
+
+TEST_F(STTest, traceSpanningTree)
+{
+    graph g = torus2D(30);
+    ws::Params p{GraphType::TORUS_2D, 30, false,
+        2, AlgorithmType::CHASELEV,
+        10000, 1, StepSpanningTreeType::COUNTER, false,
+        false, false, false};
+    tracer t(2, 1 << 14);
+    json result = experiment(p, g, &t);
+    ASSERT_TRUE(result.contains("trace"));
+#ifdef WS_TRACING
+    long long puts = 0;
+    for (auto& w : result["trace"]) puts += w["puts"].get<long long>();
+    EXPECT_EQ(result["puts"].get<long long>(), puts);
+    // Takes that found the deque empty are not events
+    for (int w = 0; w < 2; w++) {
+        for (auto& e : t.worker(w)->snapshot()) {
+            if (e.type == TraceEventType::TRACE_TAKE) {
+                EXPECT_LE(0, e.value);
+            }
+        }
+    }
+    json chrome = t.toChromeTrace();
+    EXPECT_GT(chrome["traceEvents"].size(), 2u);
+#endif
+}
+
 TEST_F(STTest, foo)
 {
     experimentComplete(GraphType::TORUS_2D, 300, false);
@@ -1366,6 +2107,660 @@ TEST_F(STTest, lockFreedom)
     delete t;
 }
 
+class ParamsTest : public ::testing::Test {
+protected:
+    ParamsTest() {}
+
+    ~ParamsTest() {}
+
+    void SetUp() {}
+
+    void TearDown() {}
+};
+
+TEST_F(ParamsTest, expandParamsProduct)
+{
+    json config = {{"graphType", {"TORUS_2D", "TORUS_3D"}},
+                   {"numThreads", {1, 2, 4}},
+                   {"algType", {"CHASELEV", "WS_NC_MULT"}},
+                   {"shape", 10}};
+    std::vector<ws::Params> params = ws::expandParams(config);
+    EXPECT_EQ(12, (int)params.size());
+    EXPECT_EQ(GraphType::TORUS_2D, params[0].graphType);
+    EXPECT_EQ(1, params[0].numThreads);
+    EXPECT_EQ(AlgorithmType::CHASELEV, params[0].algType);
+    EXPECT_FALSE(params[0].specialExecution);
+    EXPECT_EQ(AlgorithmType::WS_NC_MULT_OPT, params[1].algType);
+    EXPECT_TRUE(params[1].specialExecution);
+    EXPECT_EQ(2, params[2].numThreads);
+    EXPECT_EQ(GraphType::TORUS_3D, params[11].graphType);
+    EXPECT_EQ(10, params[11].shape);
+}
+
+TEST_F(ParamsTest, expandParamsRejectsUnknown)
+{
+    EXPECT_THROW(ws::expandParams({{"foo", 1}}), std::invalid_argument);
+    EXPECT_THROW(ws::expandParams({{"algType", "NOPE"}}), std::invalid_argument);
+    EXPECT_THROW(ws::expandParams({{"graphType", "NOPE"}}), std::invalid_argument);
+}
+
+TEST_F(ParamsTest, algTypeByNameAndOldNumbers)
+{
+    ws::Params p{GraphType::TORUS_2D, 10, false, 2, AlgorithmType::SIMPLE,
+        64, 1, StepSpanningTreeType::COUNTER, false, false, false, false};
+    for (int at = AlgorithmType::CHASELEV; at <= AlgorithmType::SIMPLE; at++) {
+        if (at == AlgorithmType::LAST) continue;
+        p.algType = static_cast<AlgorithmType>(at);
+        json j = p;
+        EXPECT_EQ(getAlgorithmTypeFromEnum(p.algType), j["algType"].get<std::string>());
+        EXPECT_EQ(p.algType, j.get<ws::Params>().algType);
+    }
+    // Files from before the names keep the numbers of the original algorithms
+    json old = p;
+    std::vector<AlgorithmType> original = {AlgorithmType::CHASELEV, AlgorithmType::CILK,
+        AlgorithmType::IDEMPOTENT_FIFO, AlgorithmType::IDEMPOTENT_LIFO, AlgorithmType::WS_NC_MULT_OPT,
+        AlgorithmType::WS_NC_MULT_LA_OPT, AlgorithmType::B_WS_NC_MULT_OPT};
+    for (int i = 0; i < (int)original.size(); i++) {
+        old["algType"] = i;
+        EXPECT_EQ(original[i], old.get<ws::Params>().algType);
+    }
+}
+
+TEST_F(ParamsTest, summarizeSample)
+{
+    json s = summarize({4.0, 1.0, 3.0, 2.0});
+    EXPECT_EQ(4, s["n"].get<int>());
+    EXPECT_DOUBLE_EQ(1.0, s["min"].get<double>());
+    EXPECT_DOUBLE_EQ(4.0, s["max"].get<double>());
+    EXPECT_DOUBLE_EQ(2.5, s["median"].get<double>());
+    EXPECT_DOUBLE_EQ(2.5, s["mean"].get<double>());
+    EXPECT_NEAR(1.29099, s["stddev"].get<double>(), 1e-4);
+    // t(0.975, 3) = 3.182
+    EXPECT_NEAR(2.5 - 3.182 * 1.29099 / 2, s["ci95"][0].get<double>(), 1e-3);
+    json one = summarize({7.0});
+    EXPECT_DOUBLE_EQ(0.0, one["stddev"].get<double>());
+}
+
+//////////////////////////////
+// Fork-join task scheduler //
+//////////////////////////////
+
+class SchedulerTest : public ::testing::Test {
+protected:
+    SchedulerTest() {}
+
+    ~SchedulerTest() {}
+
+    void SetUp() {}
+
+    void TearDown() {}
+};
+
+static int parallelFib(int n)
+{
+    if (n < 2) return n;
+    int a = 0;
+    ws::TaskGroup g;
+    g.spawn([&a, n]() { a = parallelFib(n - 1); });
+    int b = parallelFib(n - 2);
+    g.sync();
+    return a + b;
+}
+
+TEST_F(SchedulerTest, fibonacciAllAlgorithms)
+{
+    for (int at = AlgorithmType::CHASELEV; at != AlgorithmType::LAST; at++) {
+        AlgorithmType algType = static_cast<AlgorithmType>(at);
+        ws::Scheduler s(algType, 4);
+        int result = 0;
+        s.run([&]() { result = parallelFib(18); });
+        EXPECT_EQ(2584, result) << getAlgorithmTypeFromEnum(algType);
+        ws::SchedulerStats stats = s.stats();
+        EXPECT_EQ(stats.spawns, stats.executed + stats.inlined);
+        // Runs can be repeated on the same workers
+        s.run([&]() { result = parallelFib(10); });
+        EXPECT_EQ(55, result);
+    }
+}
+
+TEST_F(SchedulerTest, everyTaskRunsOnce)
+{
+    const int numTasks = 10000;
+    for (int at = AlgorithmType::CHASELEV; at != AlgorithmType::LAST; at++) {
+        AlgorithmType algType = static_cast<AlgorithmType>(at);
+        ws::Scheduler s(algType, 4, numTasks);
+        std::vector<std::atomic<int>> runs(numTasks);
+        for (auto& r : runs) r = 0;
+        s.run([&]() {
+            ws::TaskGroup g;
+            for (int i = 0; i < numTasks; i++) {
+                g.spawn([&runs, i]() { runs[i]++; });
+            }
+        });
+        for (int i = 0; i < numTasks; i++) {
+            ASSERT_EQ(1, runs[i].load()) << getAlgorithmTypeFromEnum(algType);
+        }
+    }
+}
+
+TEST_F(SchedulerTest, fullSlabRunsInline)
+{
+    ws::Scheduler s(AlgorithmType::CHASELEV, 2, 4);
+    int result = 0;
+    s.run([&]() { result = parallelFib(15); });
+    EXPECT_EQ(610, result);
+    EXPECT_LT(0, s.stats().inlined);
+}
+
+TEST_F(SchedulerTest, groupOutsideRun)
+{
+    EXPECT_THROW(ws::TaskGroup g, std::logic_error);
+    EXPECT_THROW(ws::Scheduler(AlgorithmType::SIMPLE, 2), std::invalid_argument);
+}
+
+TEST_F(SchedulerTest, parallelForCoversRange)
+{
+    const int n = 100000;
+    for (int at = AlgorithmType::CHASELEV; at != AlgorithmType::LAST; at++) {
+        AlgorithmType algType = static_cast<AlgorithmType>(at);
+        ws::Scheduler s(algType, 4, 256, 4096);
+        std::vector<std::atomic<int>> hits(n);
+        for (auto& h : hits) h = 0;
+        ws::parallelFor(s, 0, n, [&hits](int i) { hits[i]++; });
+        for (int i = 0; i < n; i++) {
+            ASSERT_EQ(1, hits[i].load()) << getAlgorithmTypeFromEnum(algType);
+        }
+    }
+}
+
+TEST_F(SchedulerTest, parallelReduceKeepsOrder)
+{
+    const int n = 100000;
+    ws::Scheduler s(AlgorithmType::CHASELEV, 4, 256, 4096);
+    long long sum = ws::parallelReduce(s, 0, n, 0LL,
+                                       [](int i) { return (long long) i; },
+                                       [](long long a, long long b) { return a + b; });
+    EXPECT_EQ((long long) n * (n - 1) / 2, sum);
+    // Intervals only join when adjacent, so any reordering shows up
+    using interval = std::pair<int, int>;
+    interval empty{-1, -1}, broken{-2, -2};
+    interval range = ws::parallelReduce(s, 0, n, empty,
+                                        [](int i) { return interval{i, i}; },
+                                        [&](interval a, interval b) {
+                                            if (a == empty) return b;
+                                            if (b == empty) return a;
+                                            if (a == broken || b == broken || a.second + 1 != b.first) return broken;
+                                            return interval{a.first, b.second};
+                                        });
+    EXPECT_EQ(0, range.first);
+    EXPECT_EQ(n - 1, range.second);
+    // Nested inside a run
+    int nested = 0;
+    s.run([&]() {
+        nested = ws::parallelReduce(s, 0, 100, 0, [](int i) { return i; },
+                                    [](int a, int b) { return a + b; });
+    });
+    EXPECT_EQ(4950, nested);
+}
+
+/////////////////////
+// Coroutine tasks //
+/////////////////////
+
+class TaskTest : public ::testing::Test {
+protected:
+    TaskTest() {}
+
+    ~TaskTest() {}
+
+    void SetUp() {}
+
+    void TearDown() {}
+};
+
+static ws::task<int> coroutineFib(int n)
+{
+    if (n < 2) co_return n;
+    ws::task<int> a = coroutineFib(n - 1);
+    co_await ws::spawn(a);
+    int b = co_await coroutineFib(n - 2);
+    co_await ws::sync();
+    co_return a.result() + b;
+}
+
+static ws::task<void> countLeaves(int depth, std::atomic<int>& leaves)
+{
+    if (depth == 0) {
+        leaves++;
+        co_return;
+    }
+    ws::task<void> left = countLeaves(depth - 1, leaves);
+    ws::task<void> right = countLeaves(depth - 1, leaves);
+    co_await ws::spawn(left);
+    co_await ws::spawn(right);
+    co_await ws::sync();
+    // A second round of spawns on the same coroutine
+    ws::task<void> again = countLeaves(0, leaves);
+    co_await ws::spawn(again);
+    co_await ws::sync();
+}
+
+static ws::task<int> throwing()
+{
+    throw std::runtime_error("task failed");
+    co_return 0;
+}
+
+TEST_F(TaskTest, fibonacciAllAlgorithms)
+{
+    for (int at = AlgorithmType::CHASELEV; at != AlgorithmType::LAST; at++) {
+        AlgorithmType algType = static_cast<AlgorithmType>(at);
+        ws::Scheduler s(algType, 4);
+        EXPECT_EQ(2584, ws::syncWait(s, coroutineFib(18))) << getAlgorithmTypeFromEnum(algType);
+    }
+}
+
+TEST_F(TaskTest, spawnAndSyncRounds)
+{
+    ws::Scheduler s(AlgorithmType::CHASELEV, 4);
+    std::atomic<int> leaves = 0;
+    ws::syncWait(s, countLeaves(10, leaves));
+    // 2^10 leaves plus one extra per internal node (2^10 - 1)
+    EXPECT_EQ(1024 + 1023, leaves.load());
+}
+
+TEST_F(TaskTest, fullSlabRunsChildInline)
+{
+    ws::Scheduler s(AlgorithmType::CHASELEV, 2, 4);
+    EXPECT_EQ(610, ws::syncWait(s, coroutineFib(15)));
+    EXPECT_LT(0, s.stats().inlined);
+}
+
+TEST_F(TaskTest, exceptionPropagates)
+{
+    ws::Scheduler s(AlgorithmType::CHASELEV, 2);
+    EXPECT_THROW(ws::syncWait(s, throwing()), std::runtime_error);
+}
+
+//////////////////////////
+// Breadth-first search //
+//////////////////////////
+
+class BfsTest : public ::testing::Test {
+protected:
+    BfsTest() {}
+
+    ~BfsTest() {}
+
+    void SetUp() {}
+
+    void TearDown() {}
+};
+
+TEST_F(BfsTest, parallelMatchesSequential)
+{
+    std::vector<graph> graphs = {torus2D(30), directedTorus2D(30), torus3D40(10)};
+    for (graph& g : graphs) {
+        int* processors = new int[1];
+        Report base{1, processors};
+        bfsResult expected = sequentialBfs(g, 0, base);
+        ASSERT_TRUE(validateBfs(g, 0, expected));
+        delete[] processors;
+        for (int w = WorkloadType::BFS_WS; w <= WorkloadType::BFS_DIRECTION_OPT; w++) {
+            for (int at = AlgorithmType::CHASELEV; at != AlgorithmType::LAST; at++) {
+                AlgorithmType algType = static_cast<AlgorithmType>(at);
+                ws::Params p{GraphType::TORUS_2D, 30, false, 4, algType,
+                    1024, 1, StepSpanningTreeType::COUNTER, g.isDirected(),
+                    false, false, isSpecial(algType)};
+                p.workload = static_cast<WorkloadType>(w);
+                processors = new int[4];
+                Report r{4, processors};
+                bfsResult result = bfs(g, 0, r, p);
+                EXPECT_TRUE(validateBfs(g, 0, result));
+                EXPECT_EQ(expected.distances, result.distances)
+                    << getWorkloadTypeFromEnum(p.workload) << " " << getAlgorithmTypeFromEnum(algType);
+                EXPECT_EQ(expected.edges, result.edges);
+                delete[] processors;
+            }
+        }
+    }
+}
+
+TEST_F(BfsTest, directionOptimizingGoesBottomUp)
+{
+    graph g = torus3D(16);
+    ws::Params p{GraphType::TORUS_3D, 16, false, 2, AlgorithmType::CHASELEV,
+        4096, 1, StepSpanningTreeType::COUNTER, false, false, false, false};
+    p.workload = WorkloadType::BFS_DIRECTION_OPT;
+    int* processors = new int[2];
+    Report r{2, processors};
+    bfsResult result = bfs(g, 0, r, p);
+    EXPECT_TRUE(validateBfs(g, 0, result));
+    EXPECT_LT(0, result.bottomUpLevels);
+    EXPECT_GT(result.levels, result.bottomUpLevels);
+    delete[] processors;
+}
+
+TEST_F(BfsTest, validateRejectsWrongLevels)
+{
+    graph g = torus2D(10);
+    int* processors = new int[1];
+    Report r{1, processors};
+    bfsResult result = sequentialBfs(g, 0, r);
+    EXPECT_EQ(10, result.levels);
+    EXPECT_EQ(200, result.edges);
+    result.distances[55]++;
+    EXPECT_FALSE(validateBfs(g, 0, result));
+    delete[] processors;
+}
+
+TEST_F(BfsTest, experimentReportsGteps)
+{
+    graph g = torus2D(30);
+    ws::Params p{GraphType::TORUS_2D, 30, false, 2, AlgorithmType::CHASELEV,
+        1024, 1, StepSpanningTreeType::COUNTER, false, false, false, false};
+    p.workload = WorkloadType::BFS_TOP_DOWN;
+    json result = experiment(p, g);
+    EXPECT_EQ("BFS_TOP_DOWN", result["workload"]);
+    EXPECT_LT(0.0, result["gteps"].get<double>());
+    EXPECT_EQ(1800, result["edges"].get<long long>());
+    EXPECT_EQ(0, result["parentsTime"].get<long>());
+    // The parents of BFS_WS are rebuilt after the clock stops
+    p.workload = WorkloadType::BFS_WS;
+    result = experiment(p, g);
+    EXPECT_LT(0, result["parentsTime"].get<long>());
+    EXPECT_LT(0.0, result["gteps"].get<double>());
+    std::vector<ws::Params> params = ws::expandParams({{"workload", {"BFS_WS", "BFS_DIRECTION_OPT"}}});
+    ASSERT_EQ(2u, params.size());
+    EXPECT_EQ(WorkloadType::BFS_WS, params[0].workload);
+    EXPECT_THROW(ws::expandParams({{"workload", "DFS"}}), std::invalid_argument);
+}
+
+class ComponentsTest : public ::testing::Test {
+protected:
+    ComponentsTest() {}
+
+    ~ComponentsTest() {}
+
+    void SetUp() {}
+
+    void TearDown() {}
+};
+
+// Three paths, a star and an isolated vertex.
+graph forest()
+{
+    graph g(false, 0, 12, GraphType::RANDOM);
+    g.addEdge(0, 1);
+    g.addEdge(1, 2);
+    g.addEdge(3, 10);
+    g.addEdge(5, 6);
+    g.addEdge(7, 4);
+    g.addEdge(7, 8);
+    g.addEdge(7, 9);
+    return g;
+}
+
+TEST_F(ComponentsTest, parallelMatchesSequential)
+{
+    std::vector<graph> graphs = {forest(), torus2D60(30), directedTorus2D60(30), torus3D40(10)};
+    for (graph& g : graphs) {
+        int* processors = new int[1];
+        Report base{1, processors};
+        componentsResult expected = sequentialComponents(g, base);
+        ASSERT_TRUE(validateComponents(g, expected));
+        delete[] processors;
+        for (int at = AlgorithmType::CHASELEV; at != AlgorithmType::LAST; at++) {
+            AlgorithmType algType = static_cast<AlgorithmType>(at);
+            ws::Params p{GraphType::TORUS_2D_60, 30, false, 4, algType,
+                1024, 1, StepSpanningTreeType::COUNTER, g.isDirected(),
+                false, false, isSpecial(algType)};
+            p.workload = WorkloadType::CONNECTED_COMPONENTS;
+            processors = new int[4];
+            Report r{4, processors};
+            componentsResult result = components(g, r, p);
+            EXPECT_TRUE(validateComponents(g, result)) << getAlgorithmTypeFromEnum(algType);
+            EXPECT_EQ(expected.labels, result.labels) << getAlgorithmTypeFromEnum(algType);
+            EXPECT_EQ(expected.sizes, result.sizes);
+            delete[] processors;
+        }
+    }
+}
+
+TEST_F(ComponentsTest, forestFinishes)
+{
+    graph g = forest();
+    EXPECT_EQ(GraphCycleType::DISCONNECTED, detectCycleType(g));
+    ws::Params p{GraphType::RANDOM, 12, false, 3, AlgorithmType::CHASELEV,
+        64, 1, StepSpanningTreeType::COUNTER, false, false, false, false};
+    int* processors = new int[3];
+    Report r{3, processors};
+    componentsResult result = components(g, r, p);
+    EXPECT_EQ(5, result.numComponents);
+    EXPECT_EQ(std::vector<int>({4, 3, 2, 2, 1}), result.sizes);
+    EXPECT_EQ(std::vector<int>({0, 0, 0, 3, 4, 5, 5, 4, 4, 4, 3, 11}), result.labels);
+    EXPECT_EQ(0, result.merges);
+    delete[] processors;
+}
+
+TEST_F(ComponentsTest, unionFindJoinsDirectedEdges)
+{
+    // Labels only flow along 2 -> 0 and 2 -> 1, which cannot lower 2
+    graph g(true, 0, 3, GraphType::RANDOM);
+    g.addEdge(2, 0);
+    g.addEdge(2, 1);
+    ws::Params p{GraphType::RANDOM, 3, false, 2, AlgorithmType::CHASELEV,
+        64, 1, StepSpanningTreeType::COUNTER, true, false, false, false};
+    int* processors = new int[2];
+    Report r{2, processors};
+    componentsResult result = components(g, r, p);
+    EXPECT_EQ(1, result.numComponents);
+    EXPECT_EQ(std::vector<int>({0, 0, 0}), result.labels);
+    EXPECT_EQ(2, result.merges);
+    result.labels[1] = 1;
+    EXPECT_FALSE(validateComponents(g, result));
+    delete[] processors;
+}
+
+TEST_F(ComponentsTest, experimentReportsComponents)
+{
+    graph g = forest();
+    ws::Params p{GraphType::RANDOM, 12, false, 2, AlgorithmType::WS_NC_MULT_OPT,
+        64, 1, StepSpanningTreeType::COUNTER, false, false, false, true};
+    p.workload = WorkloadType::CONNECTED_COMPONENTS;
+    json result = experiment(p, g);
+    EXPECT_EQ("CONNECTED_COMPONENTS", result["workload"]);
+    EXPECT_EQ(5, result["components"].get<int>());
+    EXPECT_EQ(4, result["largestComponent"].get<int>());
+    EXPECT_EQ(1, result["singletons"].get<int>());
+    EXPECT_EQ(7, result["edges"].get<long long>());
+    EXPECT_LE(0.0, result["gteps"].get<double>());
+    json stats = experimentStatistics(p, g);
+    EXPECT_EQ(5, stats["components"].get<int>());
+    EXPECT_TRUE(stats.contains("gteps"));
+}
+
+class UtsTest : public ::testing::Test {
+protected:
+    UtsTest() {}
+
+    ~UtsTest() {}
+
+    void SetUp() {}
+
+    void TearDown() {}
+
+    static ws::Params utsParams(UtsTreeType tree, AlgorithmType algType, int numThreads)
+    {
+        ws::Params p{GraphType::TORUS_2D, 10, false, numThreads, algType,
+            1024, 1, StepSpanningTreeType::COUNTER, false, false, false, isSpecial(algType)};
+        p.workload = WorkloadType::UTS;
+        p.utsTree = tree;
+        if (tree == UtsTreeType::BINOMIAL) {
+            p.utsBranching = 200;
+            p.utsQ = 0.2;
+            p.utsM = 4;
+        } else {
+            p.utsDepth = 6;
+        }
+        return p;
+    }
+};
+
+TEST_F(UtsTest, parallelMatchesSequential)
+{
+    for (UtsTreeType tree : {UtsTreeType::BINOMIAL, UtsTreeType::GEOMETRIC}) {
+        ws::Params base = utsParams(tree, AlgorithmType::SIMPLE, 1);
+        int* processors = new int[1];
+        Report r{1, processors};
+        utsResult expected = sequentialUts(r, base);
+        EXPECT_EQ(expected.nodes, r.expansions.load());
+        EXPECT_LT(100, expected.nodes);
+        if (tree == UtsTreeType::BINOMIAL) {
+            // Every node below the root has either no child or utsM of them
+            EXPECT_EQ(0, (expected.nodes - 1 - 200) % 4);
+        } else {
+            EXPECT_EQ(6, expected.maxDepth);
+        }
+        delete[] processors;
+        for (int at = AlgorithmType::CHASELEV; at != AlgorithmType::LAST; at++) {
+            AlgorithmType algType = static_cast<AlgorithmType>(at);
+            ws::Params p = utsParams(tree, algType, 4);
+            processors = new int[4];
+            Report report{4, processors};
+            utsResult result = uts(report, p);
+            EXPECT_EQ(expected.nodes, result.nodes) << getAlgorithmTypeFromEnum(algType);
+            EXPECT_EQ(expected.leaves, result.leaves);
+            EXPECT_EQ(expected.maxDepth, result.maxDepth);
+            delete[] processors;
+        }
+    }
+}
+
+TEST_F(UtsTest, seedChangesTheTree)
+{
+    ws::Params p = utsParams(UtsTreeType::BINOMIAL, AlgorithmType::SIMPLE, 1);
+    int* processors = new int[1];
+    Report first{1, processors};
+    long long nodes = sequentialUts(first, p).nodes;
+    delete[] processors;
+    processors = new int[1];
+    Report again{1, processors};
+    EXPECT_EQ(nodes, sequentialUts(again, p).nodes);
+    delete[] processors;
+    p.utsSeed = 7;
+    processors = new int[1];
+    Report other{1, processors};
+    EXPECT_NE(nodes, sequentialUts(other, p).nodes);
+    delete[] processors;
+}
+
+TEST_F(UtsTest, experimentReportsNodes)
+{
+    graph g;
+    ws::Params p = utsParams(UtsTreeType::GEOMETRIC, AlgorithmType::CHASELEV, 2);
+    json result = experiment(p, g);
+    EXPECT_EQ("UTS", result["workload"]);
+    EXPECT_EQ("GEOMETRIC", result["utsTree"]);
+    EXPECT_EQ(result["nodes"].get<long long>(), result["expansions"].get<long long>());
+    EXPECT_LT(0.0, result["nodesPerSecond"].get<double>());
+    json stats = experimentStatistics(p, g);
+    EXPECT_EQ(result["nodes"], stats["nodes"]);
+    EXPECT_TRUE(stats.contains("nodesPerSecond"));
+    std::vector<ws::Params> params = ws::expandParams({{"workload", "UTS"}, {"utsTree", "BINOMIAL"},
+                                                       {"utsBranching", {100, 2000}}});
+    ASSERT_EQ(2u, params.size());
+    EXPECT_EQ(UtsTreeType::BINOMIAL, params[1].utsTree);
+    EXPECT_EQ(2000, params[1].utsBranching);
+    EXPECT_THROW(ws::expandParams({{"utsTree", "FIXED"}}), std::invalid_argument);
+}
+
+class ReorderTest : public ::testing::Test {
+protected:
+    ReorderTest() {}
+
+    ~ReorderTest() {}
+
+    void SetUp() {}
+
+    void TearDown() {}
+};
+
+TEST_F(ReorderTest, ordersArePermutations)
+{
+    std::vector<graph> graphs = {torus2D(16), directedTorus2D60(12), torus3D(8)};
+    for (graph& g : graphs) {
+        for (int r = ReorderType::NO_REORDER; r <= ReorderType::HILBERT; r++) {
+            reordering order = vertexOrder(g, static_cast<ReorderType>(r), 2);
+            std::vector<int> sorted = order.oldId;
+            std::sort(sorted.begin(), sorted.end());
+            for (int v = 0; v < g.getNumberVertices(); v++) {
+                ASSERT_EQ(v, sorted[v]);
+                EXPECT_EQ(v, order.newId[order.oldId[v]]);
+            }
+            graph relabeled = relabel(g, order);
+            EXPECT_EQ(g.getNumberEdges(), relabeled.getNumberEdges());
+            EXPECT_EQ(order.newId[g.getRoot()], relabeled.getRoot());
+            for (int v = 0; v < g.getNumberVertices(); v++) {
+                for (int w : g.getNeighbours(v)) {
+                    EXPECT_TRUE(relabeled.hasEdge(edge(order.newId[v], order.newId[w])));
+                }
+            }
+        }
+    }
+    graph path(false, 0, 4, GraphType::RANDOM);
+    EXPECT_THROW(vertexOrder(path, ReorderType::HILBERT), std::invalid_argument);
+}
+
+TEST_F(ReorderTest, hilbertStepsToNeighbours)
+{
+    // On a power of two side consecutive cells of the curve are adjacent
+    graph g = torus2D(16);
+    reordering order = vertexOrder(g, ReorderType::HILBERT, 2);
+    for (int i = 1; i < g.getNumberVertices(); i++) {
+        int a = order.oldId[i - 1], b = order.oldId[i];
+        int distance = std::abs(a / 16 - b / 16) + std::abs(a % 16 - b % 16);
+        EXPECT_EQ(1, distance) << i;
+    }
+}
+
+TEST_F(ReorderTest, rcmNarrowsTheBand)
+{
+    graph g = torus2D(32);
+    graph rcm = relabel(g, vertexOrder(g, ReorderType::RCM, 2));
+    // Row-major ids: the wrap-around edges of the first column span the whole graph
+    EXPECT_EQ(32 * 31, bandwidth(g));
+    EXPECT_GT(bandwidth(g) / 4, bandwidth(rcm));
+    graph bfsOrder = relabel(g, vertexOrder(g, ReorderType::BFS_ORDER, 2));
+    EXPECT_EQ(0, bfsOrder.getRoot());
+}
+
+TEST_F(ReorderTest, resultsMapBack)
+{
+    graph g = torus3D40(10);
+    reordering order = vertexOrder(g, ReorderType::RCM, 2);
+    graph relabeled = relabel(g, order);
+    int* processors = new int[1];
+    Report base{1, processors};
+    bfsResult expected = sequentialBfs(g, g.getRoot(), base);
+    delete[] processors;
+    ws::Params p{GraphType::TORUS_3D_40, 10, false, 4, AlgorithmType::CHASELEV,
+        1024, 1, StepSpanningTreeType::COUNTER, false, false, false, false};
+    p.workload = WorkloadType::BFS_TOP_DOWN;
+    processors = new int[4];
+    Report r{4, processors};
+    bfsResult result = bfs(relabeled, relabeled.getRoot(), r, p);
+    EXPECT_EQ(expected.distances, toOriginal(order, result.distances));
+    bfsResult mapped;
+    mapped.distances = toOriginal(order, result.distances);
+    mapped.parents = verticesToOriginal(order, result.parents);
+    EXPECT_TRUE(validateBfs(g, g.getRoot(), mapped));
+    delete[] processors;
+    std::vector<ws::Params> params = ws::expandParams({{"reorder", {"RCM", "HILBERT"}}});
+    ASSERT_EQ(2u, params.size());
+    EXPECT_EQ(ReorderType::HILBERT, params[1].reorder);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     int ret = RUN_ALL_TESTS();